@@ -0,0 +1,33 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <chrono>
+
+// Seconds per call of fn: one warm-up call, then as many calls as fit in
+// at least minSeconds, averaged
+template <typename Fn>
+double timePerCall(Fn&& fn, double minSeconds = 0.25) {
+    using Clock = std::chrono::steady_clock;
+    fn();
+
+    size_t calls = 0;
+    const Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        ++calls;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+
+    return elapsed / calls;
+}
+
+// Written by keepResult so the optimizer cannot discard a result
+inline volatile float g_resultSink = 0.0f;
+
+// Keep the optimizer from discarding a result
+inline void keepResult(float value) {
+    g_resultSink = value;
+}
+
+#endif // BENCH_UTIL_H
@@ -0,0 +1,175 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "analysis/fft_analyzer.h"
+#include "analysis/beat_detector.h"
+#include "util/pcg_random.h"
+
+// Analysis layout used by the application
+static const int kSampleRate = 44100;
+static const int kWindowSize = 2048;
+static const int kHopSize = 256;
+static const int kBlockFrames = 1024;
+static const float kSensitivity = 0.25f;
+
+// Click track: 128 BPM for 30 seconds
+static const float kTempoBpm = 128.0f;
+static const float kTrackSeconds = 30.0f;
+
+// A detection counts for a click if it is reported within this window
+// around it, in seconds
+static const float kMatchEarly = 0.01f;
+static const float kMatchLate = 0.07f;
+
+// Background a click track is mixed over
+enum class Background {
+    Silence,
+    Bass,  // Sustained 55 Hz sine
+    Pads   // Slowly swelling A major chord
+};
+
+struct Scenario {
+    const char* name;
+    Background background;
+    float clickLevel;
+};
+
+// How one engine did on one track
+struct Score {
+    int detections = 0;
+    int matched = 0;
+    double latencySum = 0.0;
+};
+
+// Synthesize the track and the sample positions of its clicks
+static std::vector<float> makeTrack(const Scenario& scenario, std::vector<long>& clicks) {
+    const long length = static_cast<long>(kTrackSeconds * kSampleRate);
+    const long interval = static_cast<long>(60.0f / kTempoBpm * kSampleRate);
+    std::vector<float> track(length);
+
+    PcgRandom random(1);
+    for (long i = 0; i < length; ++i) {
+        float t = static_cast<float>(i) / kSampleRate;
+        float value = random.uniform(-0.01f, 0.01f);
+        if (scenario.background == Background::Bass) {
+            value += 0.3f * std::sin(2.0f * static_cast<float>(M_PI) * 55.0f * t);
+        } else if (scenario.background == Background::Pads) {
+            float swell = 0.5f + 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * 0.25f * t);
+            for (float frequency : {220.0f, 277.18f, 329.63f}) {
+                value += 0.12f * swell * std::sin(2.0f * static_cast<float>(M_PI) * frequency * t);
+            }
+        }
+        track[i] = value;
+    }
+
+    // Short decaying 3 kHz bursts on the beat
+    clicks.clear();
+    for (long start = kSampleRate / 2; start + 400 < length; start += interval) {
+        clicks.push_back(start);
+        for (int k = 0; k < 400; ++k) {
+            track[start + k] += scenario.clickLevel * std::exp(-k / 60.0f)
+                * std::sin(2.0f * static_cast<float>(M_PI) * 3000.0f * k / kSampleRate);
+        }
+    }
+    return track;
+}
+
+// Match detections to clicks, each at most once, in order
+static Score score(const std::vector<long>& clicks, const std::vector<long>& detections) {
+    const long early = static_cast<long>(kMatchEarly * kSampleRate);
+    const long late = static_cast<long>(kMatchLate * kSampleRate);
+
+    Score result;
+    result.detections = static_cast<int>(detections.size());
+    size_t next = 0;
+    for (long click : clicks) {
+        while (next < detections.size() && detections[next] < click - early) {
+            ++next;
+        }
+        if (next < detections.size() && detections[next] <= click + late) {
+            ++result.matched;
+            result.latencySum += detections[next] - click;
+            ++next;
+        }
+    }
+    return result;
+}
+
+static void printRow(const std::string& name, const Score& result, size_t clickCount) {
+    double precision = result.detections ? static_cast<double>(result.matched) / result.detections : 0.0;
+    double recall = static_cast<double>(result.matched) / clickCount;
+    double latency = result.matched ? result.latencySum / result.matched * 1000.0 / kSampleRate : 0.0;
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(10) << precision
+              << std::setw(10) << recall
+              << std::setw(14) << latency << std::endl;
+}
+
+int main() {
+    const Scenario scenarios[] = {
+        {"clicks", Background::Silence, 0.6f},
+        {"clicks under bass", Background::Bass, 0.6f},
+        {"quiet clicks under bass", Background::Bass, 0.2f},
+        {"clicks under pads", Background::Pads, 0.6f},
+    };
+
+    std::cout << "Click tracks at " << kTempoBpm << " BPM, " << kTrackSeconds << " s, "
+              << kWindowSize << "-point FFT, " << kHopSize << "-sample hop, "
+              << kBlockFrames << "-frame blocks" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(40) << "track / engine" << std::right
+              << std::setw(10) << "precision" << std::setw(10) << "recall"
+              << std::setw(14) << "latency (ms)" << std::endl;
+
+    for (const Scenario& scenario : scenarios) {
+        std::vector<long> clicks;
+        std::vector<float> track = makeTrack(scenario, clicks);
+
+        // Silence the analyzers' console logging while they run
+        std::streambuf* console = std::cout.rdbuf(nullptr);
+
+        FFTAnalyzer analyzer;
+        BeatDetector detector;
+        bool ready = analyzer.initialize(kWindowSize, kHopSize)
+            && detector.initialize(kSensitivity)
+            && detector.initializeOnsetDetection(kSampleRate, kWindowSize, kHopSize);
+        detector.setAlgorithm(BeatAlgorithm::Energy);
+
+        // Driven like the analysis thread: the block's hops go to the
+        // spectral engine, then the block to the energy engine. Detections
+        // are timed at the end of the audio that produced them.
+        std::vector<long> energyBeats;
+        std::vector<long> fluxOnsets;
+        std::vector<float> block(kBlockFrames);
+        long hopIndex = 0;
+        for (size_t start = 0; ready && start + kBlockFrames <= track.size(); start += kBlockFrames) {
+            block.assign(track.begin() + start, track.begin() + start + kBlockFrames);
+            int hops = analyzer.processAudioData(block, 1);
+            for (int hop = 0; hop < hops; ++hop) {
+                ++hopIndex;
+                if (detector.analyzeSpectrum(analyzer.getFrameLinearSpectrum(hop))) {
+                    fluxOnsets.push_back(hopIndex * kHopSize);
+                }
+            }
+
+            detector.analyzeAudio(block, 1);
+            if (detector.isBeatDetected()) {
+                energyBeats.push_back(static_cast<long>(start + kBlockFrames));
+            }
+        }
+
+        std::cout.rdbuf(console);
+        std::cout.clear();
+        if (!ready) {
+            std::cerr << "Failed to initialize the analyzers" << std::endl;
+            return 1;
+        }
+
+        printRow(std::string(scenario.name) + " / energy", score(clicks, energyBeats), clicks.size());
+        printRow(std::string(scenario.name) + " / spectral flux", score(clicks, fluxOnsets), clicks.size());
+    }
+
+    return 0;
+}
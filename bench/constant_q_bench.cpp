@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "analysis/constant_q_analyzer.h"
+#include "bench_util.h"
+
+// Layout used by the application: 72 semitones from C2, updated every 2048 samples
+static const int kSampleRate = 44100;
+static const int kHopSize = 2048;
+static const int kLowestNote = 36;
+static const int kNoteCount = 72;
+
+// Semitones further than this below the loudest one are left out of the
+// accuracy check: the sparse kernel drops weights under 1% of each note's
+// peak, so leakage far below the peak differs by design
+static const float kCheckRangeDb = 20.0f;
+
+// Naive constant-Q: each note's windowed complex exponential kept in the
+// time domain and correlated with the newest samples, one full dot product
+// per note. Same windows and gain as the sparse kernel.
+class NaiveConstantQ {
+public:
+    NaiveConstantQ(const ConstantQAnalyzer& reference) {
+        const double q = 1.0 / (std::pow(2.0, 1.0 / 12.0) - 1.0);
+        const int fftSize = reference.getFFTSize();
+        for (int index = 0; index < reference.getNoteCount(); ++index) {
+            const double frequency = reference.getNoteFrequency(index);
+            const int length = std::min(fftSize, static_cast<int>(std::ceil(q * kSampleRate / frequency)));
+
+            double windowSum = 0.0;
+            for (int n = 0; n < length; ++n) {
+                windowSum += 0.54 - 0.46 * std::cos(2.0 * M_PI * n / std::max(1, length - 1));
+            }
+
+            Kernel kernel;
+            kernel.re.resize(length);
+            kernel.im.resize(length);
+            for (int n = 0; n < length; ++n) {
+                double window = (0.54 - 0.46 * std::cos(2.0 * M_PI * n / std::max(1, length - 1))) / windowSum;
+                double phase = 2.0 * M_PI * frequency * n / kSampleRate;
+                kernel.re[n] = static_cast<float>(window * std::cos(phase));
+                kernel.im[n] = static_cast<float>(-window * std::sin(phase));
+            }
+            m_kernels.push_back(kernel);
+        }
+        m_amplitudes.resize(m_kernels.size());
+    }
+
+    // Amplitude of every note over the samples ending at newest
+    const std::vector<float>& evaluate(const float* newest) {
+        for (size_t index = 0; index < m_kernels.size(); ++index) {
+            const Kernel& kernel = m_kernels[index];
+            const size_t length = kernel.re.size();
+            const float* start = newest - length;
+            float re = 0.0f;
+            float im = 0.0f;
+            for (size_t n = 0; n < length; ++n) {
+                re += start[n] * kernel.re[n];
+                im += start[n] * kernel.im[n];
+            }
+            m_amplitudes[index] = 2.0f * std::hypot(re, im);
+        }
+        return m_amplitudes;
+    }
+
+    // Number of complex weights over all notes
+    size_t getWeightCount() const {
+        size_t count = 0;
+        for (const Kernel& kernel : m_kernels) {
+            count += kernel.re.size();
+        }
+        return count;
+    }
+
+private:
+    // One note's windowed exponential, real and imaginary parts apart
+    struct Kernel {
+        std::vector<float> re;
+        std::vector<float> im;
+    };
+
+    std::vector<Kernel> m_kernels;
+    std::vector<float> m_amplitudes;
+};
+
+int main() {
+    // Silence the analyzer's console logging during setup
+    std::streambuf* console = std::cout.rdbuf(nullptr);
+    ConstantQAnalyzer analyzer;
+    bool ready = analyzer.initialize(kSampleRate, kHopSize, kLowestNote, kNoteCount);
+    std::cout.rdbuf(console);
+    std::cout.clear();
+    if (!ready) {
+        return 1;
+    }
+
+    const int fftSize = analyzer.getFFTSize();
+    NaiveConstantQ naive(analyzer);
+
+    // A3, E4 and C#5 held, long enough to fill the longest kernel several times
+    std::vector<float> signal(fftSize * 4);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        double t = static_cast<double>(i) / kSampleRate;
+        signal[i] = static_cast<float>(0.3 * (std::sin(2.0 * M_PI * 220.0 * t)
+            + std::sin(2.0 * M_PI * 329.63 * t) + std::sin(2.0 * M_PI * 554.37 * t)));
+    }
+
+    // Accuracy: both transforms over the same newest samples
+    analyzer.processAudioData(signal.data(), signal.size(), 1);
+    const std::vector<float>& sparse = analyzer.getSemitoneSpectrum();
+    const std::vector<float>& reference = naive.evaluate(signal.data() + signal.size());
+    float peak = *std::max_element(reference.begin(), reference.end());
+    float maxError = 0.0f;
+    for (int index = 0; index < kNoteCount; ++index) {
+        if (20.0f * std::log10(reference[index] / peak + 1e-12f) < -kCheckRangeDb) {
+            continue;
+        }
+        float level = std::max(0.0f, 20.0f * std::log10(reference[index] + 1e-6f) + 96.0f) / 96.0f;
+        maxError = std::max(maxError, std::fabs(level - sparse[index]));
+    }
+
+    // Cost per hop: the whole sparse hop is the FFT, the harmonic mask and the kernel
+    size_t offset = 0;
+    double sparseTime = timePerCall([&] {
+        offset = (offset + kHopSize) % (signal.size() - kHopSize);
+        analyzer.processAudioData(signal.data() + offset, kHopSize, 1);
+        keepResult(analyzer.getSemitoneSpectrum()[0]);
+    });
+
+    // Everything after the FFT, on a precomputed spectrum of the same samples
+    fftwf_complex* spectrum = fftwf_alloc_complex(fftSize / 2 + 1);
+    float* frame = fftwf_alloc_real(fftSize);
+    std::copy(signal.end() - fftSize, signal.end(), frame);
+    fftwf_plan plan = fftwf_plan_dft_r2c_1d(fftSize, frame, spectrum, FFTW_ESTIMATE);
+    fftwf_execute(plan);
+    double kernelTime = timePerCall([&] {
+        analyzer.processSpectrum(spectrum);
+        keepResult(analyzer.getSemitoneSpectrum()[0]);
+    });
+    fftwf_destroy_plan(plan);
+    fftwf_free(frame);
+    fftwf_free(spectrum);
+
+    double naiveTime = timePerCall([&] {
+        keepResult(naive.evaluate(signal.data() + signal.size())[0]);
+    });
+
+    std::cout << "Constant-Q, " << kNoteCount << " semitones from MIDI " << kLowestNote
+              << ", FFT size " << fftSize << ", hop " << kHopSize << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(34) << "engine" << std::right
+              << std::setw(14) << "weights" << std::setw(14) << "us per hop" << std::endl;
+    std::cout << std::left << std::setw(34) << "naive per-bin correlation" << std::right
+              << std::setw(14) << naive.getWeightCount() << std::setw(14) << naiveTime * 1e6 << std::endl;
+    std::cout << std::left << std::setw(34) << "sparse, whole hop" << std::right
+              << std::setw(14) << analyzer.getKernelSize() << std::setw(14) << sparseTime * 1e6 << std::endl;
+    std::cout << std::left << std::setw(34) << "sparse, after the FFT" << std::right
+              << std::setw(14) << analyzer.getKernelSize() << std::setw(14) << kernelTime * 1e6 << std::endl;
+    std::cout << "Largest level difference within " << kCheckRangeDb << " dB of the peak: "
+              << std::setprecision(4) << maxError << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "analysis/dsp_kernels.h"
+#include "bench_util.h"
+
+// Analysis window and the stereo block downmixed into it
+static const int kWindowSize = 2048;
+static const int kBins = kWindowSize / 2 + 1;
+static const int kChannels = 2;
+
+// The per-hop loops FFTAnalyzer ran before the kernels, kept here as the
+// baseline: per-frame ring downmix, double-precision window and magnitudes,
+// log10 per bin
+
+static void oldDownmix(const float* audio, std::vector<float>& history, int& index, int channels) {
+    const float channelScale = 1.0f / channels;
+    for (int frame = 0; frame < kWindowSize; ++frame) {
+        const float* in = audio + frame * channels;
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            sum += in[c];
+        }
+        history[index] = sum * channelScale;
+        index = (index + 1) % kWindowSize;
+    }
+}
+
+static void oldWindow(const std::vector<float>& history, int index, const std::vector<double>& window,
+                      std::vector<double>& fftInput) {
+    int tail = kWindowSize - index;
+    for (int i = 0; i < tail; ++i) {
+        fftInput[i] = history[index + i];
+    }
+    for (int i = 0; i < index; ++i) {
+        fftInput[tail + i] = history[i];
+    }
+    for (int i = 0; i < kWindowSize; ++i) {
+        fftInput[i] *= window[i];
+    }
+}
+
+static void oldSpectrum(const std::vector<double>& fftOutput, std::vector<float>& spectrum) {
+    const double normalizationFactor = 2.0 / kWindowSize;
+    spectrum[0] = normalizationFactor * std::sqrt(fftOutput[0] * fftOutput[0] + fftOutput[1] * fftOutput[1]);
+    for (int i = 1; i < kBins; ++i) {
+        double real = fftOutput[2 * i];
+        double imag = fftOutput[2 * i + 1];
+        double magnitude = normalizationFactor * std::sqrt(real * real + imag * imag);
+        magnitude = 20.0 * std::log10(magnitude + 1e-6);
+        spectrum[i] = std::max(0.0, magnitude + 96.0) / 96.0;
+    }
+}
+
+static void oldSmooth(std::vector<float>& magnitudes, const std::vector<float>& spectrum) {
+    for (int i = 0; i < kBins; ++i) {
+        magnitudes[i] = 0.2f * magnitudes[i] + 0.8f * spectrum[i];
+    }
+}
+
+static void printRow(const char* name, double oldSeconds, double newSeconds) {
+    std::cout << std::left << std::setw(22) << name << std::right
+              << std::setw(12) << oldSeconds * 1e9
+              << std::setw(12) << newSeconds * 1e9
+              << std::setw(10) << oldSeconds / newSeconds << "x" << std::endl;
+}
+
+int main() {
+    std::vector<float> audio(kWindowSize * kChannels);
+    for (size_t i = 0; i < audio.size(); ++i) {
+        audio[i] = std::sin(0.013f * i) * 0.5f;
+    }
+
+    std::vector<double> windowDouble(kWindowSize);
+    std::vector<float> windowFloat(kWindowSize);
+    for (int i = 0; i < kWindowSize; ++i) {
+        windowDouble[i] = 0.5 * (1.0 - std::cos(2.0 * M_PI * i / (kWindowSize - 1)));
+        windowFloat[i] = static_cast<float>(windowDouble[i]);
+    }
+
+    // Stand-in FFT output with magnitudes spread over the dB range
+    std::vector<double> fftOutputDouble(2 * kBins);
+    std::vector<float> fftOutputFloat(2 * kBins);
+    for (int i = 0; i < 2 * kBins; ++i) {
+        fftOutputDouble[i] = std::pow(10.0, -(i % 240) / 40.0) * kWindowSize;
+        fftOutputFloat[i] = static_cast<float>(fftOutputDouble[i]);
+    }
+
+    std::vector<float> history(kWindowSize, 0.0f);
+    std::vector<float> mono(kWindowSize);
+    std::vector<double> fftInputDouble(kWindowSize);
+    std::vector<float> fftInputFloat(kWindowSize);
+    std::vector<float> linear(kBins);
+    std::vector<float> spectrum(kBins);
+    std::vector<float> magnitudes(kBins, 0.0f);
+    int historyIndex = 0;
+
+    std::cout << "Kernel timings for a " << kWindowSize << "-sample window, " << kChannels
+              << " channels (ns per call)" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(22) << "kernel" << std::right
+              << std::setw(12) << "old" << std::setw(12) << "new" << std::setw(11) << "speedup" << std::endl;
+
+    double oldTime = timePerCall([&] {
+        oldDownmix(audio.data(), history, historyIndex, kChannels);
+        keepResult(history[0]);
+    });
+    double newTime = timePerCall([&] {
+        dsp::downmix(audio.data(), mono.data(), kWindowSize, kChannels);
+        keepResult(mono[0]);
+    });
+    printRow("downmix", oldTime, newTime);
+
+    historyIndex = kWindowSize / 3;
+    oldTime = timePerCall([&] {
+        oldWindow(history, historyIndex, windowDouble, fftInputDouble);
+        keepResult(static_cast<float>(fftInputDouble[0]));
+    });
+    newTime = timePerCall([&] {
+        int tail = kWindowSize - historyIndex;
+        dsp::multiply(history.data() + historyIndex, windowFloat.data(), fftInputFloat.data(), tail);
+        dsp::multiply(history.data(), windowFloat.data() + tail, fftInputFloat.data() + tail, historyIndex);
+        keepResult(fftInputFloat[0]);
+    });
+    printRow("unroll + window", oldTime, newTime);
+
+    oldTime = timePerCall([&] {
+        oldSpectrum(fftOutputDouble, spectrum);
+        keepResult(spectrum[1]);
+    });
+    newTime = timePerCall([&] {
+        dsp::magnitude(fftOutputFloat.data(), linear.data(), kBins, 2.0f / kWindowSize);
+        spectrum[0] = linear[0];
+        dsp::normalizedDecibels(linear.data() + 1, spectrum.data() + 1, kBins - 1, 96.0f);
+        keepResult(spectrum[1]);
+    });
+    printRow("magnitude + dB", oldTime, newTime);
+
+    oldTime = timePerCall([&] {
+        oldSmooth(magnitudes, spectrum);
+        keepResult(magnitudes[1]);
+    });
+    newTime = timePerCall([&] {
+        dsp::smooth(magnitudes.data(), spectrum.data(), kBins, 0.2f);
+        keepResult(magnitudes[1]);
+    });
+    printRow("smoothing", oldTime, newTime);
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "analysis/feature_extractor.h"
+#include "util/pcg_random.h"
+#include "bench_util.h"
+
+static const int kSampleRate = 44100;
+static const int kFftSizes[] = {2048, 4096, 8192};
+
+// Interleaved stereo block analysed with every frame
+static const int kBlockFrames = 1024;
+static const int kChannels = 2;
+
+// The same features computed the straightforward way, one loop per feature
+// over the spectrum and the block, as the baseline for the fused passes
+static SpectralFeatures separateLoops(const std::vector<float>& magnitudes, std::vector<float>& previous,
+                                      const std::vector<float>& block, float binWidth) {
+    const size_t bins = magnitudes.size();
+    SpectralFeatures features;
+
+    float magnitudeSum = 0.0f;
+    float weightedSum = 0.0f;
+    for (size_t i = 0; i < bins; ++i) {
+        magnitudeSum += magnitudes[i];
+        weightedSum += i * binWidth * magnitudes[i];
+    }
+    features.centroid = magnitudeSum > 0.0f ? weightedSum / magnitudeSum : 0.0f;
+
+    float power = 0.0f;
+    for (size_t i = 0; i < bins; ++i) {
+        power += magnitudes[i] * magnitudes[i];
+    }
+    float accumulated = 0.0f;
+    size_t rolloffBin = 0;
+    for (; rolloffBin + 1 < bins; ++rolloffBin) {
+        accumulated += magnitudes[rolloffBin] * magnitudes[rolloffBin];
+        if (accumulated >= 0.85f * power) {
+            break;
+        }
+    }
+    features.rolloff = rolloffBin * binWidth;
+
+    float logPower = 0.0f;
+    for (size_t i = 0; i < bins; ++i) {
+        logPower += std::log(magnitudes[i] * magnitudes[i] + 1e-12f);
+    }
+    float meanPower = power / bins;
+    features.flatness = meanPower > 0.0f ? std::exp(logPower / bins) / meanPower : 0.0f;
+
+    float rise = 0.0f;
+    for (size_t i = 0; i < bins; ++i) {
+        rise += std::max(0.0f, magnitudes[i] - previous[i]);
+    }
+    std::copy(magnitudes.begin(), magnitudes.end(), previous.begin());
+    features.flux = magnitudeSum > 0.0f ? rise / magnitudeSum : 0.0f;
+
+    float squares = 0.0f;
+    for (float sample : block) {
+        squares += sample * sample;
+    }
+    features.rms = std::sqrt(squares / block.size());
+
+    size_t crossings = 0;
+    for (size_t i = kChannels; i < block.size(); ++i) {
+        if (std::signbit(block[i]) != std::signbit(block[i - kChannels])) {
+            ++crossings;
+        }
+    }
+    features.zeroCrossingRate = static_cast<float>(crossings) / (block.size() - kChannels);
+
+    float peak = 0.0f;
+    for (float sample : block) {
+        peak = std::max(peak, std::fabs(sample));
+    }
+    features.crestFactor = features.rms > 0.0f ? peak / features.rms : 0.0f;
+
+    return features;
+}
+
+int main() {
+    PcgRandom random(1);
+    std::vector<float> block(kBlockFrames * kChannels);
+    random.fill(block.data(), block.size(), -1.0f, 1.0f);
+
+    std::cout << "Feature cost per frame (ns), " << kBlockFrames << "-frame stereo block" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(10) << "FFT size" << std::setw(16) << "separate loops"
+              << std::setw(12) << "fused" << std::setw(11) << "speedup" << std::endl;
+
+    for (int fftSize : kFftSizes) {
+        const int bins = fftSize / 2 + 1;
+        const float binWidth = static_cast<float>(kSampleRate) / fftSize;
+
+        // Two spectra with a falling envelope, alternated so the flux is never zero
+        std::vector<float> spectra[2];
+        for (std::vector<float>& spectrum : spectra) {
+            spectrum.resize(bins);
+            for (int i = 0; i < bins; ++i) {
+                spectrum[i] = random.uniform() / (1.0f + i * 0.01f);
+            }
+        }
+
+        FeatureExtractor extractor;
+        if (!extractor.initialize(kSampleRate, fftSize)) {
+            return 1;
+        }
+
+        int frame = 0;
+        double fused = timePerCall([&] {
+            extractor.processSpectrum(spectra[++frame & 1].data());
+            extractor.processSamples(block.data(), kBlockFrames, kChannels);
+            keepResult(extractor.getFeatures().centroid);
+        });
+
+        std::vector<float> previous(bins, 0.0f);
+        double separate = timePerCall([&] {
+            SpectralFeatures features = separateLoops(spectra[++frame & 1], previous, block, binWidth);
+            keepResult(features.centroid);
+        });
+
+        std::cout << std::setw(10) << fftSize << std::setw(16) << separate * 1e9
+                  << std::setw(12) << fused * 1e9 << std::setw(10) << separate / fused << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fftw3.h>
+#include "analysis/fft_planner.h"
+
+// Window sizes the analyzer is commonly run with
+static const int kSizes[] = {1024, 2048, 4096, 8192};
+static const size_t kSizeCount = sizeof(kSizes) / sizeof(kSizes[0]);
+
+// How a child process creates its plans
+enum class PlanMode {
+    Measure,  // FFTW_MEASURE on every launch, as before the wisdom file
+    Planner   // FFTPlanner: patient search and save, or load from wisdom
+};
+
+// Plan one r2c transform per size and return the milliseconds each took
+static std::vector<double> planSizes(PlanMode mode) {
+    std::vector<double> milliseconds;
+    for (int size : kSizes) {
+        float* input = fftwf_alloc_real(size);
+        fftwf_complex* output = fftwf_alloc_complex(size / 2 + 1);
+        auto makePlan = [&](unsigned flags) {
+            return fftwf_plan_dft_r2c_1d(size, input, output, flags);
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        fftwf_plan plan = mode == PlanMode::Measure
+            ? makePlan(FFTW_MEASURE)
+            : FFTPlanner::createPlan("r2c " + std::to_string(size), makePlan);
+        milliseconds.push_back(
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        if (plan) {
+            fftwf_destroy_plan(plan);
+        }
+        fftwf_free(input);
+        fftwf_free(output);
+    }
+    return milliseconds;
+}
+
+// Run planSizes in a fresh process, so FFTW and FFTPlanner start without any
+// wisdom in memory exactly like a new launch. Results come back through a pipe.
+static bool planInChild(PlanMode mode, std::vector<double>& milliseconds) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        // Keep the planner's log out of the table
+        close(fds[0]);
+        if (!freopen("/dev/null", "w", stdout)) {
+            _exit(1);
+        }
+        std::vector<double> result = planSizes(mode);
+        bool written = write(fds[1], result.data(), result.size() * sizeof(double))
+            == static_cast<ssize_t>(result.size() * sizeof(double));
+        _exit(written ? 0 : 1);
+    }
+
+    close(fds[1]);
+    milliseconds.assign(kSizeCount, 0.0);
+    ssize_t expected = static_cast<ssize_t>(kSizeCount * sizeof(double));
+    bool received = read(fds[0], milliseconds.data(), expected) == expected;
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void printRow(const char* name, const std::vector<double>& milliseconds) {
+    std::cout << std::left << std::setw(22) << name << std::right;
+    for (double value : milliseconds) {
+        std::cout << std::setw(10) << value;
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    // A private cache directory, so the cold run really starts without wisdom
+    // and the user's wisdom file is left alone
+    char directory[] = "/tmp/musicvis_wisdom_bench_XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cerr << "Failed to create a temporary cache directory" << std::endl;
+        return 1;
+    }
+    setenv("XDG_CACHE_HOME", directory, 1);
+
+    std::vector<double> measure;
+    std::vector<double> cold;
+    std::vector<double> warm;
+    bool ok = planInChild(PlanMode::Measure, measure)
+        && planInChild(PlanMode::Planner, cold)
+        && planInChild(PlanMode::Planner, warm);
+
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+
+    if (!ok) {
+        std::cerr << "A planning run failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "FFTW r2c planning time per launch (ms)" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(22) << "size" << std::right;
+    for (int size : kSizes) {
+        std::cout << std::setw(10) << size;
+    }
+    std::cout << std::endl;
+
+    printRow("measure, no wisdom", measure);
+    printRow("first launch", cold);
+    printRow("wisdom loaded", warm);
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "analysis/harmonic_percussive_separator.h"
+#include "util/pcg_random.h"
+#include "bench_util.h"
+
+static const int kSampleRate = 44100;
+static const int kHopSize = 256;
+static const int kFftSizes[] = {1024, 2048, 4096, 8192};
+
+// Distinct hops cycled through, so the medians keep changing
+static const int kHopCount = 64;
+
+// Filter lengths the separator picks: 0.2 s of hops and 500 Hz of bins,
+// rounded to odd
+static int oddLength(float count) {
+    return std::max(3, static_cast<int>(std::lround(count)) | 1);
+}
+
+// The textbook way: keep the last timeLength hops and, for every bin, copy
+// each window out and nth_element it. Medians only, no masks, so this
+// baseline does less work than the separator.
+class NaiveMedians {
+public:
+    NaiveMedians(int bins, int timeLength, int frequencyLength)
+        : m_bins(bins)
+        , m_timeLength(timeLength)
+        , m_frequencyLength(frequencyLength)
+        , m_next(0)
+        , m_history(static_cast<size_t>(bins) * timeLength, 0.0f)
+        , m_padded(bins + frequencyLength - 1, 0.0f)
+        , m_scratch(std::max(timeLength, frequencyLength))
+        , m_harmonic(bins)
+        , m_percussive(bins)
+    {
+    }
+
+    void process(const float* magnitudes) {
+        std::copy(magnitudes, magnitudes + m_bins, m_history.begin() + static_cast<size_t>(m_next) * m_bins);
+        m_next = (m_next + 1) % m_timeLength;
+
+        for (int bin = 0; bin < m_bins; ++bin) {
+            for (int hop = 0; hop < m_timeLength; ++hop) {
+                m_scratch[hop] = m_history[static_cast<size_t>(hop) * m_bins + bin];
+            }
+            std::nth_element(m_scratch.begin(), m_scratch.begin() + m_timeLength / 2, m_scratch.begin() + m_timeLength);
+            m_harmonic[bin] = m_scratch[m_timeLength / 2];
+        }
+
+        const int radius = m_frequencyLength / 2;
+        std::copy(magnitudes, magnitudes + m_bins, m_padded.begin() + radius);
+        for (int bin = 0; bin < m_bins; ++bin) {
+            std::copy(m_padded.begin() + bin, m_padded.begin() + bin + m_frequencyLength, m_scratch.begin());
+            std::nth_element(m_scratch.begin(), m_scratch.begin() + radius, m_scratch.begin() + m_frequencyLength);
+            m_percussive[bin] = m_scratch[radius];
+        }
+    }
+
+    float getHarmonic(int bin) const {
+        return m_harmonic[bin];
+    }
+
+private:
+    int m_bins;
+    int m_timeLength;
+    int m_frequencyLength;
+    int m_next;
+    std::vector<float> m_history;
+    std::vector<float> m_padded;
+    std::vector<float> m_scratch;
+    std::vector<float> m_harmonic;
+    std::vector<float> m_percussive;
+};
+
+int main() {
+    PcgRandom random(5);
+
+    std::cout << "Harmonic/percussive separation cost per hop (us), hop " << kHopSize
+              << " at " << kSampleRate << " Hz" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(10) << "FFT size" << std::setw(8) << "bins" << std::setw(16) << "time x freq"
+              << std::setw(14) << "nth_element" << std::setw(16) << "sliding median" << std::setw(11) << "speedup"
+              << std::endl;
+
+    for (int fftSize : kFftSizes) {
+        const int bins = fftSize / 2 + 1;
+        const int timeLength = oddLength(0.2f * kSampleRate / kHopSize);
+        const int frequencyLength = oddLength(500.0f * fftSize / kSampleRate);
+
+        std::vector<float> hops(static_cast<size_t>(bins) * kHopCount);
+        random.fill(hops);
+
+        HarmonicPercussiveSeparator separator;
+        if (!separator.initialize(kSampleRate, fftSize, kHopSize)) {
+            return 1;
+        }
+        NaiveMedians naive(bins, timeLength, frequencyLength);
+
+        // Fill the time windows before timing
+        for (int hop = 0; hop < kHopCount; ++hop) {
+            separator.process(hops.data() + static_cast<size_t>(hop) * bins);
+            naive.process(hops.data() + static_cast<size_t>(hop) * bins);
+        }
+
+        int hop = 0;
+        double sliding = timePerCall([&] {
+            separator.process(hops.data() + static_cast<size_t>(++hop % kHopCount) * bins);
+            keepResult(separator.getPercussive()[0]);
+        });
+        double sorted = timePerCall([&] {
+            naive.process(hops.data() + static_cast<size_t>(++hop % kHopCount) * bins);
+            keepResult(naive.getHarmonic(0));
+        });
+
+        std::cout << std::setw(10) << fftSize << std::setw(8) << bins
+                  << std::setw(11) << timeLength << " x " << std::setw(2) << frequencyLength
+                  << std::setw(14) << sorted * 1e6 << std::setw(16) << sliding * 1e6
+                  << std::setw(10) << sorted / sliding << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "visualization/particle_system.h"
+#include "util/pcg_random.h"
+#include "util/thread_pool.h"
+
+// Steady population simulated at every thread count
+static const size_t kParticles = 1000000;
+static const int kFrames = 120;
+
+// Lifetime of a fresh particle: at 60 fps about 1% of them die each frame
+static const float kMaxLife = 1.66f;
+
+// Order-dependent hash of every field, to check that the thread count does
+// not change the result
+static uint64_t hashState(const ParticleSystem& system) {
+    uint64_t hash = 1469598103934665603ull;
+    for (const float* field : {system.getX(), system.getY(), system.getVelocityX(), system.getVelocityY(),
+                               system.getSize(), system.getLife(), system.getMaxLife(), system.getRed(),
+                               system.getGreen(), system.getBlue(), system.getAlpha()}) {
+        for (size_t i = 0; i < system.size(); ++i) {
+            uint32_t bits;
+            std::memcpy(&bits, field + i, sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+// A particle somewhere on screen, alive for at most life seconds
+static void randomParticle(PcgRandom& random, const ParticleStep& step, float life, ParticleSpawn& p) {
+    p.x = random.uniform(0.0f, step.width);
+    p.y = random.uniform(0.0f, step.height);
+    p.vx = random.uniform(-300.0f, 300.0f);
+    p.vy = random.uniform(-300.0f, 300.0f);
+    p.size = random.uniform(2.0f, 10.0f);
+    p.life = life;
+    p.r = random.uniform();
+    p.g = random.uniform();
+    p.b = random.uniform();
+    p.a = 1.0f;
+}
+
+int main(int argc, char* argv[]) {
+    // Thread counts up to the hardware threads, or to the first argument
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    maxThreads = std::max(1, maxThreads);
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    ParticleStep step;
+    step.deltaTime = 1.0f / 60.0f;
+    step.gravity = 60.0f;
+    step.drag = 0.98f;
+    step.lifeDrain = 1.0f / 60.0f;
+    step.width = 1280.0f;
+    step.height = 720.0f;
+
+    std::cout << "Particle frame cost (update and respawn), " << kParticles << " particles, "
+              << kFrames << " frames" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "ms/frame" << std::setw(16) << "Mparticles/s"
+              << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::setw(14) << "same state"
+              << std::endl;
+
+    double singleThread = 0.0;
+    uint64_t reference = 0;
+    for (int threads : threadCounts) {
+        auto pool = std::make_shared<ThreadPool>();
+        if (!pool->start(threads - 1)) {
+            std::cerr << "Failed to start " << threads - 1 << " workers" << std::endl;
+            return 1;
+        }
+
+        // Lifetimes spread so deaths are steady from the first frame
+        ParticleSystem system;
+        system.initialize(kParticles, pool);
+        system.spawnBatch(kParticles, 0, [&](size_t, PcgRandom& random, ParticleSpawn& p) {
+            randomParticle(random, step, random.uniform(0.0f, kMaxLife), p);
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 1; frame <= kFrames; ++frame) {
+            system.update(step);
+            system.spawnBatch(kParticles - system.size(), frame, [&](size_t, PcgRandom& random, ParticleSpawn& p) {
+                randomParticle(random, step, kMaxLife, p);
+            });
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t hash = hashState(system);
+        if (threads == 1) {
+            singleThread = seconds;
+            reference = hash;
+        }
+
+        double speedup = singleThread / seconds;
+        std::cout << std::setw(8) << threads << std::setw(12) << seconds / kFrames * 1e3
+                  << std::setw(16) << kParticles * kFrames / seconds * 1e-6
+                  << std::setw(9) << speedup << "x" << std::setw(11) << speedup / threads * 100.0 << "%"
+                  << std::setw(14) << (hash == reference ? "yes" : "NO") << std::endl;
+    }
+
+    return 0;
+}
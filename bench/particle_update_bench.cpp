@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "visualization/particle_system.h"
+#include "util/pcg_random.h"
+
+static const size_t kParticleCounts[] = {1000, 10000, 100000, 1000000};
+
+// Particle updates timed per size, at least 20 frames
+static const size_t kUpdatesPerSize = 30000000;
+
+// Lifetime of a fresh particle: at 60 fps about 1% of them die each frame
+// and are respawned outside the timed update
+static const float kMaxLife = 1.66f;
+
+// The array-of-structs particle and update ParticleVisualizer used before
+// ParticleSystem, kept as the baseline
+struct Particle {
+    float x, y;
+    float vx, vy;
+    float size;
+    float life;
+    float maxLife;
+    std::array<float, 4> color;
+};
+
+static void updateParticles(std::vector<Particle>& particles, const ParticleStep& step) {
+    for (Particle& p : particles) {
+        p.x += p.vx * step.deltaTime;
+        p.y += p.vy * step.deltaTime;
+        p.vy += step.gravity * step.deltaTime;
+        p.vx *= step.drag;
+        p.vy *= step.drag;
+
+        if (p.x < 0) {
+            p.x = 0;
+            p.vx = -p.vx * 0.8f;
+        } else if (p.x > step.width) {
+            p.x = step.width;
+            p.vx = -p.vx * 0.8f;
+        }
+
+        if (p.y < 0) {
+            p.y = 0;
+            p.vy = -p.vy * 0.8f;
+        } else if (p.y > step.height) {
+            p.y = step.height;
+            p.vy = -p.vy * 0.8f;
+        }
+
+        p.life -= step.lifeDrain;
+    }
+
+    particles.erase(
+        std::remove_if(particles.begin(), particles.end(), [](const Particle& p) { return p.life <= 0.0f; }),
+        particles.end());
+}
+
+// A random particle somewhere on screen
+static Particle randomParticle(PcgRandom& random, const ParticleStep& step, float life) {
+    Particle p;
+    p.x = random.uniform(0.0f, step.width);
+    p.y = random.uniform(0.0f, step.height);
+    p.vx = random.uniform(-300.0f, 300.0f);
+    p.vy = random.uniform(-300.0f, 300.0f);
+    p.size = 3.0f;
+    p.life = life;
+    p.maxLife = kMaxLife;
+    p.color = {1.0f, 1.0f, 1.0f, 1.0f};
+    return p;
+}
+
+static void spawn(ParticleSystem& system, const Particle& p) {
+    system.spawn(p.x, p.y, p.vx, p.vy, p.size, p.life, p.color[0], p.color[1], p.color[2], p.color[3]);
+}
+
+int main() {
+    ParticleStep step;
+    step.deltaTime = 1.0f / 60.0f;
+    step.gravity = 60.0f;
+    step.drag = 0.98f;
+    step.lifeDrain = 1.0f / 60.0f;
+    step.width = 1280.0f;
+    step.height = 720.0f;
+
+    std::cout << "Particle update cost per frame (us), single thread" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(10) << "particles" << std::setw(18) << "array of structs"
+              << std::setw(18) << "struct of arrays" << std::setw(11) << "speedup" << std::endl;
+
+    for (size_t count : kParticleCounts) {
+        PcgRandom random(2);
+        std::vector<Particle> structs;
+        structs.reserve(count);
+        ParticleSystem arrays;
+        arrays.initialize(count);
+
+        // Same particles in both, with lifetimes spread so deaths are steady
+        for (size_t i = 0; i < count; ++i) {
+            Particle p = randomParticle(random, step, random.uniform(0.0f, kMaxLife));
+            structs.push_back(p);
+            spawn(arrays, p);
+        }
+
+        const size_t frames = std::max<size_t>(20, kUpdatesPerSize / count);
+        double structTime = 0.0;
+        double arrayTime = 0.0;
+        for (size_t frame = 0; frame < frames; ++frame) {
+            auto start = std::chrono::steady_clock::now();
+            updateParticles(structs, step);
+            auto middle = std::chrono::steady_clock::now();
+            arrays.update(step);
+            auto end = std::chrono::steady_clock::now();
+            structTime += std::chrono::duration<double>(middle - start).count();
+            arrayTime += std::chrono::duration<double>(end - middle).count();
+
+            while (structs.size() < count) {
+                structs.push_back(randomParticle(random, step, kMaxLife));
+            }
+            while (arrays.size() < count) {
+                spawn(arrays, randomParticle(random, step, kMaxLife));
+            }
+        }
+
+        std::cout << std::setw(10) << count << std::setw(18) << structTime / frames * 1e6
+                  << std::setw(18) << arrayTime / frames * 1e6
+                  << std::setw(10) << structTime / arrayTime << "x" << std::endl;
+    }
+
+    return 0;
+}
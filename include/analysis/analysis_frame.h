@@ -0,0 +1,67 @@
+#ifndef ANALYSIS_FRAME_H
+#define ANALYSIS_FRAME_H
+
+#include <vector>
+#include <cstdint>
+#include "analysis/beat_detector.h"
+#include "analysis/feature_extractor.h"
+
+// Snapshot of everything the analysis thread produced up to one point in the
+// stream. Frames are published whole through a triple buffer, so the render
+// thread always reads a consistent set of results.
+struct AnalysisFrame {
+    // Increments with every published frame
+    uint64_t sequence = 0;
+
+    // Stream time of the newest analysed sample, in seconds
+    double timestamp = 0.0;
+
+    // Newest callback-sized block of interleaved samples
+    std::vector<float> samples;
+    int channels = 0;
+
+    // Magnitude spectrum of the newest hop (fftSize/2 + 1 bins)
+    std::vector<float> spectrum;
+
+    // Band levels, from the multi-resolution bank when it runs, otherwise
+    // from the filterbank over the spectrum
+    std::vector<float> bands;
+
+    // Spectrum of each input channel (normalized 0-1), empty unless the
+    // multichannel analyzer runs
+    std::vector<std::vector<float>> channelSpectra;
+
+    // Mid and side level (0-1) and left/right correlation (-1 to 1) per
+    // band, empty without a stereo pair
+    std::vector<float> midBands;
+    std::vector<float> sideBands;
+    std::vector<float> correlation;
+
+    // Spectral and temporal features of the newest hop and block
+    SpectralFeatures features;
+
+    // Constant-Q level of each semitone (0-1) and the pitch class profile
+    // (12 bins from C, peak = 1)
+    std::vector<float> semitones;
+    std::vector<float> chroma;
+
+    // Beat from the selected algorithm and the per-band beats. When read
+    // through AnalysisThread::acquireFrame these cover every beat since the
+    // previous acquire, so beats in frames the renderer skipped are not lost
+    // and a frame read twice does not repeat its beats.
+    bool beatDetected = false;
+    BandBeatState bandBeats;
+
+    // Running beat totals the flags above are derived from
+    uint64_t beatCount = 0;
+    std::vector<uint32_t> bandBeatCounts;
+
+    // Tempo estimate and the position within the current beat
+    float bpm = 0.0f;
+    float beatPhase = 0.0f;
+
+    // Algorithm the beat flag came from
+    BeatAlgorithm algorithm = BeatAlgorithm::Energy;
+};
+
+#endif // ANALYSIS_FRAME_H
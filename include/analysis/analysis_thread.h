@@ -0,0 +1,104 @@
+#ifndef ANALYSIS_THREAD_H
+#define ANALYSIS_THREAD_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include "analysis/analysis_frame.h"
+#include "util/triple_buffer.h"
+
+class AudioManager;
+class FFTAnalyzer;
+class BeatDetector;
+class Filterbank;
+class FeatureExtractor;
+class ConstantQAnalyzer;
+class MultichannelAnalyzer;
+
+// Runs the FFT, filterbank, constant-Q transform, feature extraction, beat
+// detection and the optional per-channel analysis on their own thread, fed from the audio capture ring, and
+// publishes each result as an AnalysisFrame through a triple buffer. The render loop picks up the
+// newest frame without blocking, so analysis keeps pace with the audio
+// whatever the frame rate.
+// Once started, the analyzers belong to this thread; change them only
+// through the methods below.
+class AnalysisThread {
+public:
+    AnalysisThread(
+        std::shared_ptr<AudioManager> audioManager,
+        std::shared_ptr<FFTAnalyzer> fftAnalyzer,
+        std::shared_ptr<BeatDetector> beatDetector,
+        std::shared_ptr<Filterbank> filterbank,
+        std::shared_ptr<FeatureExtractor> featureExtractor,
+        std::shared_ptr<ConstantQAnalyzer> constantQAnalyzer,
+        std::shared_ptr<MultichannelAnalyzer> multichannelAnalyzer = nullptr
+    );
+    ~AnalysisThread();
+
+    // Start analysing, returns false if the thread could not be created
+    bool start();
+
+    // Stop analysing and join the thread
+    void stop();
+
+    // Check if the thread is running
+    bool isRunning() const;
+
+    // Render thread: switch to the newest frame, returns true if it is new
+    bool acquireFrame();
+
+    // Render thread: frame picked up by the last acquireFrame
+    const AnalysisFrame& getFrame() const;
+
+    // Any thread: select the beat algorithm, applied before the next block
+    void setBeatAlgorithm(BeatAlgorithm algorithm);
+
+    // Any thread: the selected beat algorithm
+    BeatAlgorithm getBeatAlgorithm() const;
+
+private:
+    // Thread body
+    void run();
+
+    // Analyse everything the capture published since the last call and
+    // publish a frame, returns false if there was nothing new
+    bool analyzeNewSamples();
+
+    // Analysis stages
+    std::shared_ptr<AudioManager> m_audioManager;
+    std::shared_ptr<FFTAnalyzer> m_fftAnalyzer;
+    std::shared_ptr<BeatDetector> m_beatDetector;
+    std::shared_ptr<Filterbank> m_filterbank;
+    std::shared_ptr<FeatureExtractor> m_featureExtractor;
+    std::shared_ptr<ConstantQAnalyzer> m_constantQAnalyzer;
+    std::shared_ptr<MultichannelAnalyzer> m_multichannelAnalyzer;
+
+    // Worker thread and its run flag
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    // Beat algorithm requested by other threads
+    std::atomic<BeatAlgorithm> m_beatAlgorithm;
+
+    // Frames between the analysis thread and the render thread
+    TripleBuffer<AnalysisFrame> m_frames;
+
+    // Analysis thread: samples read from the ring this step
+    std::vector<float> m_newSamples;
+
+    // Analysis thread: frames published and sample frames analysed so far
+    uint64_t m_sequence;
+    uint64_t m_framesAnalyzed;
+
+    // Analysis thread: beat totals carried into every frame
+    uint64_t m_beatCount;
+    std::vector<uint32_t> m_bandBeatCounts;
+
+    // Render thread: beat totals of the last acquired frame
+    uint64_t m_seenBeatCount;
+    std::vector<uint32_t> m_seenBandBeatCounts;
+};
+
+#endif // ANALYSIS_THREAD_H
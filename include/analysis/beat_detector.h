@@ -2,38 +2,159 @@
 #define BEAT_DETECTOR_H
 
 #include <vector>
-#include <deque>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+class OnsetDetector;
+class TempoTracker;
+class HarmonicPercussiveSeparator;
+
+// Algorithm used to decide when a beat is reported
+enum class BeatAlgorithm {
+    Energy,        // Time-domain RMS and derivative energy against a dynamic threshold
+    SpectralFlux,  // Onsets from the per-hop spectra (needs initializeOnsetDetection)
+    Predicted      // Beats from the tempo clock, announced ahead of time; falls
+                   // back to spectral-flux onsets while the tempo is uncertain
+};
+
+// Frequency band watched by its own beat detector
+struct BeatBand {
+    std::string name;
+    float lowFrequency;     // Lower edge in Hz
+    float highFrequency;    // Upper edge in Hz
+    float threshold;        // Standard deviations above the running mean
+    float cooldownSeconds;  // Minimum time between two beats in this band
+};
+
+// Indices of the default bands
+enum BeatBandIndex {
+    kKickBand = 0,
+    kSnareBand = 1,
+    kHiHatBand = 2
+};
+
+// Per-band beat results for the last analyzed block
+struct BandBeatState {
+    // Bit i is set when band i fired since the previous block
+    uint32_t beatMask = 0;
+
+    // Latest energy of each band (0 - 1, like the spectrum)
+    std::vector<float> energies;
+};
 
 class BeatDetector {
 public:
     BeatDetector();
     ~BeatDetector();
 
-    // Initialize the beat detector with a given sensitivity
-    bool initialize(float sensitivity);
+    // Initialize the beat detector with a given sensitivity and the number of
+    // blocks the dynamic threshold looks back over
+    bool initialize(float sensitivity, int historySize = 43);
+    
+    // Set up the spectrum-driven engines (onsets, tempo, band beats) for the
+    // FFT analyzer's layout
+    bool initializeOnsetDetection(int sampleRate, int fftSize, int hopSize);
+    
+    // Replace the watched frequency bands (at most 32)
+    bool setBands(const std::vector<BeatBand>& bands);
     
-    // Analyze audio data for beats
-    void analyzeAudio(const std::vector<float>& audioData);
+    // Kick, snare and hi-hat bands used by default
+    static std::vector<BeatBand> getDefaultBands();
+    
+    // Announce predicted beats this many seconds early to hide pipeline latency
+    void setPredictionLookahead(float seconds);
+    
+    // Analyze a block of interleaved audio with the given channel count for beats
+    void analyzeAudio(const std::vector<float>& audioData, int channels);
+    
+    // Feed one hop's linear magnitudes (FFTAnalyzer::getFrameLinearSpectrum)
+    // to the spectral-flux and band engines, returns true if an onset was
+    // found at this hop. Only the percussive part of the hop reaches them, so
+    // sustained pads and vocals do not read as onsets.
+    bool analyzeSpectrum(const float* magnitudes);
+    
+    // Select the detection algorithm at runtime
+    void setAlgorithm(BeatAlgorithm algorithm);
+    
+    // Get the active detection algorithm
+    BeatAlgorithm getAlgorithm() const;
+    
+    // Get a display name for an algorithm
+    static const char* getAlgorithmName(BeatAlgorithm algorithm);
     
     // Check if a beat is detected
     bool isBeatDetected() const;
     
     // Get the current energy level
     float getEnergy() const;
+    
+    // Per-band beats and energies for the last block
+    const BandBeatState& getBandBeats() const;
+    
+    // Get the configured bands
+    const std::vector<BeatBand>& getBands() const;
+    
+    // Estimated tempo in beats per minute, 0 while unknown
+    float getTempo() const;
+    
+    // Position within the current beat (0 = on the beat, approaching 1)
+    float getBeatPhase() const;
+    
+    // Confidence of the tempo estimate (0 - 1)
+    float getTempoConfidence() const;
+    
+    // Seconds until the next predicted beat
+    float getTimeToNextBeat() const;
 
 private:
+    // Run the energy algorithm, returns true on a beat
+    bool detectEnergyBeat(const std::vector<float>& audioData, int channels);
+    
+    // Map the configured bands onto FFT bins and reset their statistics
+    void layoutBands();
+    
+    // Update every band from one spectrum in a single pass, returns the
+    // mask of bands that fired
+    uint32_t detectBandBeats(const float* spectrum);
+    
     // Calculate energy (RMS) of the audio data
     float calculateEnergy(const std::vector<float>& audioData);
     
     // Calculate derivative energy - good for drum detection
     float calculateDerivativeEnergy(const std::vector<float>& samples);
     
-    // History of energy values for dynamic threshold
-    std::deque<float> m_energyHistory;
+    // Add an energy value to the history and update the running statistics
+    void pushEnergy(float energy);
+    
+    // History of energy values for dynamic threshold, used as a ring
+    std::vector<float> m_energyHistory;
     
     // Number of history values to keep
     int m_historySize;
     
+    // Next write index and number of valid values in the history ring
+    int m_historyIndex;
+    int m_historyCount;
+    
+    // Exponentially weighted sum of the history and the sum of its weights,
+    // their ratio is the recency-weighted average energy
+    double m_weightedSum;
+    double m_weightSum;
+    
+    // Weight of a value once it is historySize blocks old
+    double m_oldestWeight;
+    
+    // Mean and sum of squared deviations over the history window (Welford)
+    double m_windowMean;
+    double m_windowM2;
+    
+    // Energy of the previous block
+    float m_previousEnergy;
+    
+    // Scratch buffer for the downmixed start of one block
+    std::vector<float> m_localSamples;
+    
     // Sensitivity value (0.0 - 1.0)
     float m_sensitivity;
     
@@ -51,6 +172,56 @@ private:
     
     // Cooldown period in samples
     int m_cooldownPeriod;
+    
+    // Active detection algorithm
+    BeatAlgorithm m_algorithm;
+    
+    // Spectral-flux engine, null until initializeOnsetDetection
+    std::unique_ptr<OnsetDetector> m_onsetDetector;
+    
+    // Removes the harmonic part of each hop before the spectral engines,
+    // null until initializeOnsetDetection
+    std::unique_ptr<HarmonicPercussiveSeparator> m_separator;
+    
+    // Percussive part of the last hop, normalized like the FFT spectrum
+    std::vector<float> m_percussiveSpectrum;
+    
+    // Tempo and beat clock driven by the onset envelope, null until
+    // initializeOnsetDetection
+    std::unique_ptr<TempoTracker> m_tempoTracker;
+    
+    // An onset arrived through analyzeSpectrum since the last analyzeAudio
+    bool m_onsetPending;
+    
+    // A predicted beat came due since the last analyzeAudio
+    bool m_predictedBeatPending;
+    
+    // Spectrum layout the band bins were computed for
+    int m_sampleRate;
+    int m_fftSize;
+    int m_hopSize;
+    
+    // Configured frequency bands
+    std::vector<BeatBand> m_bands;
+    
+    // Per-band state, one entry per band (structure of arrays)
+    std::vector<int> m_bandFirstBin;
+    std::vector<int> m_bandLastBin;
+    std::vector<float> m_bandThreshold;
+    std::vector<float> m_bandMean;
+    std::vector<float> m_bandVariance;
+    std::vector<float> m_bandPrevious;
+    std::vector<int> m_bandCooldown;
+    std::vector<int> m_bandCooldownHops;
+    
+    // Weight of a new hop in the running band statistics
+    float m_bandAlpha;
+    
+    // Bands that fired since the last analyzeAudio
+    uint32_t m_pendingBandMask;
+    
+    // Band results for the last block
+    BandBeatState m_bandBeats;
 };
 
 #endif // BEAT_DETECTOR_H
\ No newline at end of file
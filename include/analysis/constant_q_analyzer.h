@@ -0,0 +1,94 @@
+#ifndef CONSTANT_Q_ANALYZER_H
+#define CONSTANT_Q_ANALYZER_H
+
+#include <vector>
+#include <cstddef>
+#include <fftw3.h>
+#include "analysis/fft_analyzer.h"
+#include "analysis/harmonic_percussive_separator.h"
+
+// Constant-Q transform with one bin per semitone, using the sparse spectral
+// kernel of Brown and Puckette. Each note's windowed complex exponential is
+// transformed once at initialization; its spectrum is concentrated in a few
+// bins around the note, so only that run is kept. Every hop then costs one
+// real FFT of the unwindowed signal plus one short complex dot product per
+// note. Kernels end at the newest sample, so high notes react as fast as
+// their short windows allow. The spectrum is masked down to its harmonic
+// part first, so drums do not smear across the semitones and the chroma.
+class ConstantQAnalyzer {
+public:
+    ConstantQAnalyzer();
+    ~ConstantQAnalyzer();
+
+    // Initialize for noteCount semitones starting at lowestNote (MIDI
+    // number), updated every hopSize samples. The FFT size is the power of
+    // two that holds the longest kernel.
+    bool initialize(int sampleRate, int hopSize, int lowestNote = 36, int noteCount = 72);
+
+    // Push interleaved audio, returns true if the spectrum was updated
+    bool processAudioData(const float* audioData, size_t frameCount, int channels);
+
+    // Evaluate the kernel on the harmonic part of one complex spectrum of
+    // fftSize/2 + 1 bins
+    void processSpectrum(const fftwf_complex* spectrum);
+
+    // Level of each semitone, normalized 0-1 over 96 dB like the FFT spectrum
+    const std::vector<float>& getSemitoneSpectrum() const;
+
+    // Energy of each pitch class (C first) summed over octaves, peak = 1
+    const std::vector<float>& getChroma() const;
+
+    // Get the centre frequency of a semitone bin in Hz
+    float getNoteFrequency(int index) const;
+
+    // Get the MIDI number of the first semitone bin
+    int getLowestNote() const;
+
+    // Get the number of semitone bins
+    int getNoteCount() const;
+
+    // Get the FFT size the kernel was built for
+    int getFFTSize() const;
+
+    // Number of complex weights kept in the sparse kernel
+    size_t getKernelSize() const;
+
+private:
+    // Build the sparse spectral kernel for the current layout
+    bool buildKernel();
+
+    // Rectangular-window STFT feeding the kernel
+    FFTAnalyzer m_fftAnalyzer;
+
+    // Harmonic/percussive split over the bins the kernel reaches
+    HarmonicPercussiveSeparator m_separator;
+
+    // Magnitudes and harmonic-masked complex values of those bins
+    std::vector<float> m_binMagnitudes;
+    std::vector<float> m_harmonicSpectrum;
+
+    // Layout
+    int m_sampleRate;
+    int m_fftSize;
+    int m_lowestNote;
+    int m_noteCount;
+
+    // First bin, number of bins and weight offset of each note's kernel
+    std::vector<int> m_kernelFirstBin;
+    std::vector<int> m_kernelLength;
+    std::vector<int> m_kernelOffset;
+
+    // Kept kernel weights of all notes back to back, as (re, im) pairs
+    std::vector<float> m_kernel;
+
+    // Linear amplitude of each semitone
+    std::vector<float> m_amplitudes;
+
+    // Normalized semitone spectrum
+    std::vector<float> m_semitones;
+
+    // Pitch class profile
+    std::vector<float> m_chroma;
+};
+
+#endif // CONSTANT_Q_ANALYZER_H
@@ -0,0 +1,63 @@
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+#include <cstddef>
+
+// Vectorized single-precision kernels for the analysis pipeline. Each kernel
+// uses AVX2 or SSE2 when the compiler targets them and falls back to scalar
+// code otherwise; all paths produce the same results to within rounding.
+namespace dsp {
+
+// Average interleaved channels into a mono buffer
+void downmix(const float* interleaved, float* mono, size_t frames, int channels);
+
+// Split interleaved channels into one buffer per channel
+void deinterleave(const float* interleaved, float* const* planar, size_t frames, int channels);
+
+// dest[i] = src[i] * window[i]
+void multiply(const float* src, const float* window, float* dest, size_t count);
+
+// dest[i] = scale * |complex[i]| for interleaved (re, im) pairs
+void magnitude(const float* complexPairs, float* dest, size_t count, float scale);
+
+// Map linear magnitudes onto 0-1 over the given dB range:
+// dest[i] = max(0, 20 * log10(src[i] + 1e-6) + rangeDb) / rangeDb
+void normalizedDecibels(const float* src, float* dest, size_t count, float rangeDb);
+
+// Sum of a[i] * b[i]
+float dotProduct(const float* a, const float* b, size_t count);
+
+// Complex sum of a[i] * b[i] over count interleaved (re, im) pairs
+void complexDotProduct(const float* a, const float* b, size_t count, float& re, float& im);
+
+// One-pole smoothing: state[i] = keep * state[i] + (1 - keep) * input[i]
+void smooth(float* state, const float* input, size_t count, float keep);
+
+// Sums over one magnitude spectrum gathered by spectrumSums
+struct SpectrumSums {
+    float magnitude;      // Sum of magnitudes
+    float weightedIndex;  // Sum of bin index * magnitude
+    float power;          // Sum of squared magnitudes
+    float logPower;       // Sum of log2 of the squared magnitudes (floored)
+    float rise;           // Sum of the positive changes against the previous spectrum
+};
+
+// One fused pass over linear magnitudes: gathers the sums, overwrites previous
+// with the magnitudes, and stores the power of every chunkSize bins (a
+// multiple of 8) in chunkPower
+SpectrumSums spectrumSums(const float* magnitudes, float* previous, float* chunkPower,
+                          size_t count, size_t chunkSize);
+
+// Sums over one block of interleaved samples gathered by blockSums
+struct BlockSums {
+    float squares;     // Sum of squared samples
+    float peak;        // Largest absolute sample
+    size_t crossings;  // Sign changes between consecutive frames, over all channels
+};
+
+// One fused pass over a block of interleaved samples
+BlockSums blockSums(const float* interleaved, size_t count, int channels);
+
+} // namespace dsp
+
+#endif // DSP_KERNELS_H
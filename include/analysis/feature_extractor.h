@@ -0,0 +1,58 @@
+#ifndef FEATURE_EXTRACTOR_H
+#define FEATURE_EXTRACTOR_H
+
+#include <vector>
+#include <cstddef>
+
+// Spectral and temporal features of one analysis frame
+struct SpectralFeatures {
+    float centroid = 0.0f;          // Magnitude-weighted mean frequency in Hz
+    float rolloff = 0.0f;           // Frequency below which 85% of the power lies, in Hz
+    float flatness = 0.0f;          // Geometric / arithmetic mean of the power (0 tonal - 1 noise)
+    float flux = 0.0f;              // Positive magnitude change since the last frame, relative to the total (0 - 1)
+    float rms = 0.0f;               // Root mean square of the block
+    float zeroCrossingRate = 0.0f;  // Sign changes per sample, per channel
+    float crestFactor = 0.0f;       // Peak / RMS of the block
+};
+
+// Computes SpectralFeatures next to FFTAnalyzer. The spectral features come
+// from one fused vector pass over the linear magnitudes of the newest hop,
+// the temporal ones from one fused pass over the interleaved sample block.
+class FeatureExtractor {
+public:
+    FeatureExtractor();
+    ~FeatureExtractor();
+
+    // Initialize for the analyzer's sample rate and FFT size
+    bool initialize(int sampleRate, int fftSize);
+
+    // Update the spectral features from fftSize/2 + 1 linear magnitudes
+    void processSpectrum(const float* magnitudes);
+
+    // Update the temporal features from a block of interleaved samples
+    void processSamples(const float* samples, size_t frameCount, int channels);
+
+    // Forget the previous spectrum so the next flux starts from silence
+    void reset();
+
+    // Features of the last processed spectrum and block
+    const SpectralFeatures& getFeatures() const;
+
+private:
+    // Width of one FFT bin in Hz
+    float m_binWidth;
+
+    // Number of frequency bins
+    int m_numBins;
+
+    // Magnitudes of the previous spectrum, for the flux
+    std::vector<float> m_previousMagnitudes;
+
+    // Power of each chunk of bins, for the rolloff search
+    std::vector<float> m_chunkPower;
+
+    // Latest features
+    SpectralFeatures m_features;
+};
+
+#endif // FEATURE_EXTRACTOR_H
@@ -2,56 +2,185 @@
 #define FFT_ANALYZER_H
 
 #include <vector>
+#include <memory>
 #include <complex>
 #include <fftw3.h>
 
+class PolyphaseDecimator;
+class Filterbank;
+
+// Window applied to each hop before the FFT
+enum class WindowFunction {
+    Hann,        // Smooth taper for display spectra
+    Rectangular  // No taper, for engines that window in the frequency domain
+};
+
 class FFTAnalyzer {
 public:
     FFTAnalyzer();
     ~FFTAnalyzer();
 
-    // Initialize the FFT analyzer with a given window size
-    bool initialize(int windowSize);
+    // Initialize the FFT analyzer with a window size and hop size in samples.
+    // Up to batchSize hops completed by one call are transformed together.
+    bool initialize(int windowSize, int hopSize, int batchSize = 8,
+                    WindowFunction window = WindowFunction::Hann);
     
-    // Process audio data and compute FFT
-    void processAudioData(const std::vector<float>& audioData);
+    // Push interleaved audio into the STFT, running one FFT per completed hop.
+    // Hops are windowed as they complete and transformed in batches, so a large
+    // block (offline analysis, catch-up after a stall) costs a few batched FFT
+    // calls. Returns the number of hops processed by this call.
+    int processAudioData(const std::vector<float>& audioData, int channels);
+    int processAudioData(const float* audioData, size_t frameCount, int channels);
     
-    // Get the processed spectrum data
+    // Get the processed spectrum data, smoothed across hops for display
     const std::vector<float>& getSpectrumData() const;
     
+    // Linear magnitudes (2/N scaled) of the newest hop, before log scaling
+    const std::vector<float>& getLinearSpectrum() const;
+    
+    // Complex FFT output of the newest hop (windowSize/2 + 1 bins), valid
+    // until the next processAudioData call; nullptr before the first hop
+    const fftwf_complex* getComplexSpectrum() const;
+    
+    // Number of hops produced by the last processAudioData call
+    int getFrameCount() const;
+    
+    // Unsmoothed spectrum of one hop from the last processAudioData call
+    const float* getFrameSpectrum(int frame) const;
+    
+    // Linear magnitudes (2/N scaled) of one hop from the last processAudioData call
+    const float* getFrameLinearSpectrum(int frame) const;
+    
     // Get the window size
     int getWindowSize() const;
     
+    // Get the hop size
+    int getHopSize() const;
+    
     // Get the number of frequency bins
     int getNumBins() const;
+    
+    // Also run a multi-resolution bank on every block (call after initialize):
+    // a long window over the audio decimated by decimation for the bass, and a
+    // short window at full rate above the crossover, merged into bandCount
+    // log-spaced bands. Sharp bass and fast highs without a long full-rate FFT.
+    bool enableMultiResolution(int sampleRate, int decimation, int lowWindowSize,
+                               int highWindowSize, int bandCount);
+    
+    // Check if the multi-resolution bank is running
+    bool isMultiResolutionEnabled() const;
+    
+    // Merged log-frequency spectrum of the bank (normalized 0-1 like the spectrum)
+    const std::vector<float>& getMultiResolutionSpectrum() const;
+    
+    // Frequency in Hz where the bank switches from the long to the short window
+    float getCrossoverFrequency() const;
 
 private:
-    // Apply window function to reduce spectral leakage
-    void applyWindow();
+    // Window the current history into the next free batch row
+    void queueHop();
+    
+    // Transform all queued hops and append their spectra
+    void flushHops();
+    
+    // Copy the history window into dest, applying the window function
+    void applyWindow(float* dest);
     
-    // Compute magnitudes from complex FFT results
-    void computeMagnitudes();
+    // Compute linear and normalized magnitudes from one row of complex FFT
+    // results into the matching rows
+    void computeMagnitudes(const fftwf_complex* fftOutput, float* linear, float* spectrum);
+    
+    // Feed a downmixed block to the multi-resolution bank
+    void processMultiResolution(const float* mono, size_t frameCount);
+    
+    // Release FFTW plans and buffers
+    void releaseFFT();
     
     // Window size (number of samples)
     int m_windowSize;
     
+    // Samples between successive windows
+    int m_hopSize;
+    
+    // Mono sample history covering one window, used as a ring
+    std::vector<float> m_history;
+    
+    // Next write index into the history ring
+    int m_historyIndex;
+    
+    // Scratch buffer for the downmixed input block
+    std::vector<float> m_monoBuffer;
+    
+    // Samples pushed since the last hop
+    int m_samplesSinceHop;
+    
+    // Spectra of the hops from the last processAudioData call (frames x bins)
+    std::vector<float> m_frameSpectra;
+    
+    // Linear magnitudes of the same hops (frames x bins)
+    std::vector<float> m_frameLinearSpectra;
+    
+    // Number of rows used in m_frameSpectra
+    int m_frameCount;
+    
     // Number of frequency bins (windowSize/2 + 1)
     int m_numBins;
     
-    // Input buffer for FFT
-    double* m_fftInput;
+    // Maximum hops transformed by one batched FFT call
+    int m_batchSize;
+    
+    // Windowed hops waiting in the batch input
+    int m_pendingHops;
+    
+    // Batch output row holding the newest transformed hop, -1 before the first
+    int m_newestRow;
+    
+    // Distance between batch input rows in floats, padded to 64 bytes
+    int m_inputStride;
     
-    // Output buffer for FFT
-    fftw_complex* m_fftOutput;
+    // Distance between batch output rows in complex values, padded to 64 bytes
+    int m_outputStride;
     
-    // FFTW plan
-    fftw_plan m_fftPlan;
+    // Batch input buffer (batchSize rows of windowed samples)
+    float* m_batchInput;
+    
+    // Batch output buffer (batchSize rows of complex bins)
+    fftwf_complex* m_batchOutput;
+    
+    // Single-window plan, also run on individual rows of a partial batch
+    fftwf_plan m_fftPlan;
+    
+    // Plan transforming a full batch of rows in one call
+    fftwf_plan m_batchPlan;
     
     // Window function coefficients
-    std::vector<double> m_window;
+    std::vector<float> m_window;
     
     // Processed spectrum magnitudes
     std::vector<float> m_magnitudes;
+    
+    // Linear magnitudes of the newest hop
+    std::vector<float> m_linearMagnitudes;
+    
+    // Multi-resolution bank: decimator and long-window analyzer for the bass,
+    // short-window analyzer for the highs, and the bands taken from each
+    std::unique_ptr<PolyphaseDecimator> m_decimator;
+    std::unique_ptr<FFTAnalyzer> m_lowAnalyzer;
+    std::unique_ptr<FFTAnalyzer> m_highAnalyzer;
+    std::unique_ptr<Filterbank> m_lowBands;
+    std::unique_ptr<Filterbank> m_highBands;
+    
+    // Scratch buffer for the decimated block
+    std::vector<float> m_decimatedBuffer;
+    
+    // Number of merged bands below the crossover
+    int m_lowBandCount;
+    
+    // Crossover frequency in Hz
+    float m_crossoverFrequency;
+    
+    // Merged spectrum, low bands followed by high bands
+    std::vector<float> m_multiResolutionSpectrum;
 };
 
 #endif // FFT_ANALYZER_H
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef FFT_PLANNER_H
+#define FFT_PLANNER_H
+
+#include <string>
+#include <functional>
+#include <fftw3.h>
+
+// Creates FFTW plans through a wisdom file in the user cache directory.
+// The first run plans with FFTW_PATIENT and saves the result; later runs
+// load the wisdom and plan instantly. Planning is serialized because the
+// FFTW planner is not thread-safe.
+class FFTPlanner {
+public:
+    // Build a plan; makePlan is called with the FFTW planner flags to use.
+    // The description is only used for the startup log.
+    static fftwf_plan createPlan(
+        const std::string& description,
+        const std::function<fftwf_plan(unsigned flags)>& makePlan
+    );
+
+    // Total time spent planning so far in seconds
+    static double getTotalPlanningTime();
+
+private:
+    // Import the wisdom file once per process
+    static void loadWisdom();
+
+    // Write the current wisdom back to the cache file
+    static void saveWisdom();
+
+    // Get the wisdom file path, empty if there is no cache directory
+    static std::string getWisdomPath();
+};
+
+#endif // FFT_PLANNER_H
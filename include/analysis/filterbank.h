@@ -0,0 +1,75 @@
+#ifndef FILTERBANK_H
+#define FILTERBANK_H
+
+#include <vector>
+
+// Frequency layout of the filterbank bands
+enum class FilterbankScale {
+    Log,     // Triangular bands with log-spaced centres
+    Mel,     // Triangular bands with mel-spaced centres
+    Octave   // Rectangular fractional-octave bands
+};
+
+// Maps FFT magnitude bins onto a small set of perceptual bands. The band
+// matrix is sparse (each band covers one contiguous run of bins), is built
+// once per layout and is applied with one dot product per band.
+class Filterbank {
+public:
+    Filterbank();
+    ~Filterbank();
+
+    // Build the band matrix, does nothing if the layout is unchanged. The
+    // bands span minFrequency to maxFrequency (0 = Nyquist).
+    bool initialize(int sampleRate, int fftSize, int bandCount, FilterbankScale scale = FilterbankScale::Log,
+                    float minFrequency = 20.0f, float maxFrequency = 0.0f);
+
+    // Apply the matrix to a spectrum of fftSize/2 + 1 bins
+    void process(const std::vector<float>& spectrum);
+
+    // Apply the matrix to one spectrum row, writing bandCount values
+    void apply(const float* spectrum, float* bands) const;
+
+    // Band energies from the last process call (normalized 0-1 like the spectrum)
+    const std::vector<float>& getBandData() const;
+
+    // Get the number of bands
+    int getBandCount() const;
+
+    // Get the centre frequency of a band in Hz
+    float getBandFrequency(int band) const;
+
+private:
+    // Add one band's weights, normalized to sum to one
+    void addBand(int firstBin, const std::vector<float>& weights, float centerFrequency);
+
+    // Layout the matrix was built for
+    int m_sampleRate;
+    int m_fftSize;
+    int m_bandCount;
+    FilterbankScale m_scale;
+    float m_minFrequency;
+    float m_maxFrequency;
+
+    // Number of spectrum bins the matrix expects
+    int m_numBins;
+
+    // First bin of each band
+    std::vector<int> m_bandFirstBin;
+
+    // Number of bins in each band
+    std::vector<int> m_bandLength;
+
+    // Offset of each band's weights in m_weights
+    std::vector<int> m_bandOffset;
+
+    // Non-zero weights of all bands, stored back to back
+    std::vector<float> m_weights;
+
+    // Centre frequency of each band in Hz
+    std::vector<float> m_bandFrequencies;
+
+    // Band energies from the last process call
+    std::vector<float> m_bandData;
+};
+
+#endif // FILTERBANK_H
@@ -0,0 +1,72 @@
+#ifndef HARMONIC_PERCUSSIVE_SEPARATOR_H
+#define HARMONIC_PERCUSSIVE_SEPARATOR_H
+
+#include <vector>
+#include "analysis/sliding_median.h"
+
+// Real-time harmonic/percussive separation by median filtering (Fitzgerald).
+// Sustained tones are smooth along time and percussion is smooth along
+// frequency, so each hop the magnitude of every bin is median-filtered over
+// its recent hops (harmonic estimate) and over its neighbouring bins
+// (percussive estimate). The two estimates become soft masks that split the
+// hop's magnitudes three ways (Driedger): a bin goes to the harmonic or the
+// percussive part only where that estimate clearly dominates, the rest is
+// residual and dropped. The time filter is causal, so it looks back
+// over about 0.2 s; the frequency filter spans about 500 Hz. Both run on
+// SlidingMedian, so a hop costs O(bins * log(window)).
+class HarmonicPercussiveSeparator {
+public:
+    HarmonicPercussiveSeparator();
+    ~HarmonicPercussiveSeparator();
+
+    // Initialize for the spectrum layout of an STFT. Only the first binCount
+    // bins are separated; 0 means all fftSize/2 + 1.
+    bool initialize(int sampleRate, int fftSize, int hopSize, int binCount = 0);
+
+    // Separate one hop of linear magnitudes (binCount values)
+    void process(const float* magnitudes);
+
+    // Only push one hop into the time medians, leaving the outputs alone.
+    // For hops whose masks nobody reads, so the time filter still spans
+    // 0.2 s of audio when several hops arrive at once.
+    void advance(const float* magnitudes);
+
+    // Harmonic and percussive magnitudes of the last hop; together they are
+    // at most the input, the residual is in neither
+    const std::vector<float>& getHarmonic() const;
+    const std::vector<float>& getPercussive() const;
+
+    // Fraction of each bin assigned to the harmonic part (0-1), for masking
+    // a complex spectrum
+    const std::vector<float>& getHarmonicMask() const;
+
+    // Forget the hop history
+    void reset();
+
+    // Get the number of separated bins
+    int getBinCount() const;
+
+private:
+    // One running median across time per bin
+    std::vector<SlidingMedian> m_timeMedians;
+
+    // Running median across frequency, restarted every hop
+    SlidingMedian m_frequencyMedian;
+
+    // Bins on each side of the centre bin in the frequency filter
+    int m_frequencyRadius;
+
+    // Harmonic and percussive estimates of the last hop
+    std::vector<float> m_harmonicEnvelope;
+    std::vector<float> m_percussiveEnvelope;
+
+    // Outputs
+    std::vector<float> m_harmonicMask;
+    std::vector<float> m_harmonic;
+    std::vector<float> m_percussive;
+
+    // Number of separated bins
+    int m_binCount;
+};
+
+#endif // HARMONIC_PERCUSSIVE_SEPARATOR_H
@@ -0,0 +1,92 @@
+#ifndef MULTICHANNEL_ANALYZER_H
+#define MULTICHANNEL_ANALYZER_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include "audio/channel_layout.h"
+#include "analysis/filterbank.h"
+
+class FFTAnalyzer;
+class ThreadPool;
+
+// Per-channel spectra for streams of up to eight channels, plus mid/side
+// levels and left/right correlation per band when the layout has a stereo
+// pair. Each block is deinterleaved once into planar buffers, and the
+// channels' STFTs run as independent tasks on a shared thread pool, so N
+// channels cost about N / threads single-channel analyses. The mid/side and
+// correlation values come from the pair's complex spectra (mid and side are
+// linear combinations of them), so they need no extra FFTs.
+class MultichannelAnalyzer {
+public:
+    MultichannelAnalyzer();
+    ~MultichannelAnalyzer();
+
+    // Initialize for a channel layout and STFT layout, with bandCount bands
+    // for the stereo values. pool may be null to run on the calling thread.
+    bool initialize(const ChannelLayout& layout, int sampleRate, int windowSize, int hopSize,
+                    int bandCount, std::shared_ptr<ThreadPool> pool);
+
+    // Largest channel count initialize() accepts
+    static int getMaxChannels();
+
+    // Push interleaved audio in the layout, returns the number of hops
+    int processAudioData(const float* audioData, size_t frameCount);
+
+    // Get the channel layout
+    const ChannelLayout& getLayout() const;
+
+    // Smoothed spectrum of one channel, normalized 0-1 like FFTAnalyzer's
+    const std::vector<float>& getChannelSpectrum(int channel) const;
+
+    // Mid and side level per band (normalized 0-1), empty without a pair
+    const std::vector<float>& getMidBands() const;
+    const std::vector<float>& getSideBands() const;
+
+    // Left/right correlation per band (-1 to 1), empty without a pair
+    const std::vector<float>& getCorrelation() const;
+
+private:
+    // Mid/side levels and correlation from the pair's newest hop
+    void analyzePair();
+
+    // Layout
+    ChannelLayout m_layout;
+    int m_windowSize;
+
+    // One STFT per channel
+    std::vector<std::unique_ptr<FFTAnalyzer>> m_analyzers;
+
+    // Hops each channel's STFT produced in the last call
+    std::vector<int> m_hops;
+
+    // Planar copy of the last block, one row per channel
+    std::vector<float> m_planar;
+    std::vector<float*> m_channelPointers;
+
+    // Workers shared with the rest of the application
+    std::shared_ptr<ThreadPool> m_pool;
+
+    // Bands for the stereo values
+    Filterbank m_filterbank;
+
+    // Per-bin powers of the pair's newest hop: mid, side, left, right and
+    // the real part of the cross spectrum
+    std::vector<float> m_binMid;
+    std::vector<float> m_binSide;
+    std::vector<float> m_binLeft;
+    std::vector<float> m_binRight;
+    std::vector<float> m_binCross;
+
+    // Band sums of the per-bin left, right and cross powers
+    std::vector<float> m_bandLeft;
+    std::vector<float> m_bandRight;
+    std::vector<float> m_bandCross;
+
+    // Outputs
+    std::vector<float> m_midBands;
+    std::vector<float> m_sideBands;
+    std::vector<float> m_correlation;
+};
+
+#endif // MULTICHANNEL_ANALYZER_H
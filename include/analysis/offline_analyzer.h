@@ -0,0 +1,30 @@
+#ifndef OFFLINE_ANALYZER_H
+#define OFFLINE_ANALYZER_H
+
+#include <string>
+
+// Runs the analysis chain over a whole file without a window or audio
+// device, as fast as the CPU allows, and writes per-frame results to CSV
+class OfflineAnalyzer {
+public:
+    OfflineAnalyzer();
+    ~OfflineAnalyzer();
+
+    // Initialize with the FFT window size, hop size in frames and beat sensitivity
+    bool initialize(int windowSize, int hopSize, float beatSensitivity);
+
+    // Analyze an audio file and write one CSV row per hop to outputPath
+    bool analyzeFile(const std::string& inputPath, const std::string& outputPath);
+
+private:
+    // FFT window size
+    int m_windowSize;
+
+    // Frames per analysis hop
+    int m_hopSize;
+
+    // Beat detector sensitivity
+    float m_beatSensitivity;
+};
+
+#endif // OFFLINE_ANALYZER_H
@@ -0,0 +1,80 @@
+#ifndef ONSET_DETECTOR_H
+#define ONSET_DETECTOR_H
+
+#include <vector>
+#include "analysis/filterbank.h"
+
+// Spectral-flux onset detector driven by the per-hop spectra FFTAnalyzer
+// already produces. Each hop the spectrum is grouped into log bands, the
+// positive band differences are summed into a novelty value, and a peak in
+// that novelty above an adaptive median threshold is reported as an onset.
+// Peak picking needs one hop of look-ahead, so onsets are reported one hop
+// after the frame they belong to.
+class OnsetDetector {
+public:
+    OnsetDetector();
+    ~OnsetDetector();
+
+    // Initialize for the analyzer's sample rate, FFT size and hop size
+    bool initialize(int sampleRate, int fftSize, int hopSize, float sensitivity);
+
+    // Process one hop's spectrum (fftSize/2 + 1 normalized bins), returns
+    // true if the previous hop was an onset
+    bool processFrame(const float* spectrum);
+
+    // Clear the history, e.g. when the source changes
+    void reset();
+
+    // Novelty value of the last processed hop
+    float getFlux() const;
+
+    // Threshold the last onset candidate was compared against
+    float getThreshold() const;
+
+    // Delay between an onset and its report, in hops
+    int getLatencyHops() const;
+
+private:
+    // Median of the flux history
+    float computeMedian();
+
+    // Band grouping of the spectrum
+    Filterbank m_filterbank;
+
+    // Band energies of the current and previous hop
+    std::vector<float> m_bands;
+    std::vector<float> m_previousBands;
+
+    // Recent flux values used for the adaptive threshold, as a ring
+    std::vector<float> m_fluxHistory;
+
+    // Scratch copy of the history for the median
+    std::vector<float> m_medianScratch;
+
+    // Next write index and number of valid values in m_fluxHistory
+    int m_historyIndex;
+    int m_historyCount;
+
+    // Running sum of m_fluxHistory
+    float m_historySum;
+
+    // Flux of the last three hops, newest first
+    float m_flux;
+    float m_previousFlux;
+    float m_olderFlux;
+
+    // Threshold = median + sensitivity * mean over the history
+    float m_sensitivity;
+    float m_threshold;
+
+    // Minimum number of hops between two onsets
+    int m_minIntervalHops;
+
+    // Hops since the last reported onset
+    int m_hopsSinceOnset;
+
+    // Hops processed since initialize or reset
+    int m_framesSeen;
+};
+
+#endif // ONSET_DETECTOR_H
@@ -0,0 +1,52 @@
+#ifndef POLYPHASE_DECIMATOR_H
+#define POLYPHASE_DECIMATOR_H
+
+#include <vector>
+#include <cstddef>
+
+// Low-pass filters a mono stream and keeps every factor-th sample. The FIR is
+// split into factor sub-filters (its polyphase components), each fed with
+// every factor-th input, so only the samples that are kept get computed and
+// each output costs factor short dot products. The delay lines are stored
+// twice over so every dot product reads one contiguous run.
+class PolyphaseDecimator {
+public:
+    PolyphaseDecimator();
+    ~PolyphaseDecimator();
+
+    // Initialize for an integer decimation factor, with tapsPerPhase taps in
+    // each sub-filter (the prototype filter has factor * tapsPerPhase taps)
+    bool initialize(int factor, int tapsPerPhase = 16);
+
+    // Filter count input samples and write the decimated ones to output,
+    // which must hold count / factor + 1 values. Returns the number written.
+    size_t process(const float* input, size_t count, float* output);
+
+    // Clear the delay lines
+    void reset();
+
+    // Get the decimation factor
+    int getFactor() const;
+
+private:
+    // Decimation factor
+    int m_factor;
+
+    // Taps in each sub-filter
+    int m_tapsPerPhase;
+
+    // Sub-filter coefficients, one row per phase, each row reversed so it
+    // lines up with its delay line oldest sample first
+    std::vector<float> m_coefficients;
+
+    // One delay line per phase, each 2 * tapsPerPhase long
+    std::vector<float> m_delayLines;
+
+    // Write position shared by all delay lines
+    int m_position;
+
+    // Phase the next input sample belongs to, counts down to 0
+    int m_phase;
+};
+
+#endif // POLYPHASE_DECIMATOR_H
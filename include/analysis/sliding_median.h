@@ -0,0 +1,63 @@
+#ifndef SLIDING_MEDIAN_H
+#define SLIDING_MEDIAN_H
+
+#include <vector>
+
+// Running median over the last windowSize values. The window is split into a
+// max-heap holding the lower half and a min-heap holding the upper half, so
+// the median sits at the heap roots. The heaps store ring slots rather than
+// values and every slot knows where it sits in its heap, so the value that
+// drops out of the window is overwritten in place and sifted: each push
+// costs O(log windowSize) and nothing is allocated after initialize.
+class SlidingMedian {
+public:
+    SlidingMedian();
+    ~SlidingMedian();
+
+    // Initialize for a window of windowSize values
+    bool initialize(int windowSize);
+
+    // Add a value, dropping the oldest once the window is full, and return
+    // the median of the values now in the window
+    float push(float value);
+
+    // Median of the values in the window, 0 when empty
+    float getMedian() const;
+
+    // Empty the window
+    void reset();
+
+    // Get the window length
+    int getWindowSize() const;
+
+private:
+    // Restore the heap order around one entry of the lower or upper heap
+    void siftLower(int index);
+    void siftUpper(int index);
+
+    // Move the root of one heap into the other
+    void moveLowerToUpper();
+    void moveUpperToLower();
+
+    // Window values as a ring, indexed by slot
+    std::vector<float> m_values;
+
+    // Slots of the lower half (max-heap) and upper half (min-heap)
+    std::vector<int> m_lower;
+    std::vector<int> m_upper;
+
+    // Heap position of each slot: index into m_lower, or ~index into m_upper
+    std::vector<int> m_position;
+
+    // Entries in each heap
+    int m_lowerCount;
+    int m_upperCount;
+
+    // Slot the next value goes to, the oldest one once the window is full
+    int m_nextSlot;
+
+    // Window length
+    int m_windowSize;
+};
+
+#endif // SLIDING_MEDIAN_H
@@ -0,0 +1,101 @@
+#ifndef TEMPO_TRACKER_H
+#define TEMPO_TRACKER_H
+
+#include <vector>
+#include <cstdint>
+#include <fftw3.h>
+
+// Estimates tempo from an onset envelope and runs a beat clock locked to it.
+// A few times per second the envelope window is autocorrelated through an
+// FFT to find the beat period, and a comb over the window finds the beat
+// phase. Between estimates the clock free-runs, so the next beat can be
+// announced ahead of time to hide analysis and render latency.
+class TempoTracker {
+public:
+    TempoTracker();
+    ~TempoTracker();
+
+    // Initialize for an envelope sampled at frameRate values per second
+    bool initialize(float frameRate, float windowSeconds = 6.0f);
+
+    // Add one envelope value, returns true if a beat is due within the lookahead
+    bool processFrame(float onsetStrength);
+
+    // Clear the envelope and the beat clock
+    void reset();
+
+    // Announce beats this many seconds before they are due
+    void setLookahead(float seconds);
+
+    // Estimated tempo in beats per minute, 0 until enough envelope is seen
+    float getBpm() const;
+
+    // Position within the current beat (0 = on the beat, approaching 1)
+    float getBeatPhase() const;
+
+    // Strength of the tempo estimate (0 - 1)
+    float getConfidence() const;
+
+    // Seconds until the next predicted beat
+    float getTimeToNextBeat() const;
+
+private:
+    // Autocorrelate the envelope window and pick the beat period
+    void estimateTempo();
+
+    // Align the beat clock to the envelope with a comb at the beat period
+    void estimatePhase();
+
+    // Release FFTW plans and buffers
+    void releaseFFT();
+
+    // Envelope values per second
+    float m_frameRate;
+
+    // Envelope window, used as a ring
+    std::vector<float> m_envelope;
+    int m_envelopeIndex;
+    int m_envelopeCount;
+
+    // Window unrolled oldest first, for the phase search
+    std::vector<float> m_window;
+
+    // Autocorrelation FFT size (at least twice the window, power of two)
+    int m_fftSize;
+
+    // Real FFT buffer and its spectrum
+    float* m_fftBuffer;
+    fftwf_complex* m_fftSpectrum;
+
+    // Forward and inverse plans for the autocorrelation
+    fftwf_plan m_forwardPlan;
+    fftwf_plan m_inversePlan;
+
+    // Lag range searched, in frames
+    int m_minLag;
+    int m_maxLag;
+
+    // Frames between tempo estimates and frames since the last one
+    int m_updateInterval;
+    int m_framesSinceUpdate;
+
+    // Beat period in frames, 0 while unknown
+    double m_period;
+
+    // Tempo confidence (0 - 1)
+    float m_confidence;
+
+    // Index of the newest envelope frame since reset
+    int64_t m_frameIndex;
+
+    // Frame position of the next beat on the clock
+    double m_nextBeat;
+
+    // Last beat that was announced, so each beat fires once
+    double m_lastAnnouncedBeat;
+
+    // Lookahead in frames
+    double m_lookaheadFrames;
+};
+
+#endif // TEMPO_TRACKER_H
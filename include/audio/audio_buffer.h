@@ -3,26 +3,47 @@
 
 #include <string>
 #include <vector>
-#include <mutex>
+#include <atomic>
+#include <memory>
 
 #ifdef USE_LIBSNDFILE
 #include <sndfile.h>
 #endif
 
+class StreamDecoder;
+class PcmCache;
+
+// Holds the track being played: fully decoded, mapped from the PCM cache,
+// or streamed by a background decoder. Nothing here takes a lock, so the
+// audio callback can read without blocking. Loading a track or calling
+// reset() must not overlap readSamples(); AudioManager closes its stream
+// before either.
 class AudioBuffer {
 public:
     AudioBuffer();
     ~AudioBuffer();
 
-    // Load audio data from a file
-    bool loadFromFile(const std::string& filePath);
+    // Load audio data from a file. A freshly decoded file is written to the
+    // PCM cache unless storeInCache is false; cached files are used either way.
+    bool loadFromFile(const std::string& filePath, bool storeInCache = true);
+    
+    // Open a file for streaming playback, decoding chunks in the background
+    bool openStream(const std::string& filePath);
     
     // Get a chunk of samples for playback or processing
     std::vector<float> getSamples(size_t numSamples);
     
+    // Copy up to numSamples interleaved samples into dest without allocating
+    // or locking, returns the number of samples written. atEnd, if given, is
+    // set to whether every sample has now been played.
+    size_t readSamples(float* dest, size_t numSamples, bool* atEnd = nullptr);
+    
     // Reset playback position to the beginning
     void reset();
     
+    // Check if all samples have been played
+    bool isAtEnd() const;
+    
     // Get the sample rate
     int getSampleRate() const;
     
@@ -30,11 +51,23 @@ public:
     int getChannelCount() const;
 
 private:
+    // Serve samples from the decoded-PCM cache if it holds this file
+    bool loadFromCache(const std::string& filePath);
+    
     // Audio data storage
     std::vector<float> m_audioData;
     
-    // Current position in the buffer
-    size_t m_position;
+    // Memory-mapped cache entry, null when samples live in m_audioData
+    std::unique_ptr<PcmCache> m_pcmCache;
+    
+    // Samples being played, from either m_audioData or the cache mapping
+    const float* m_samples;
+    
+    // Number of samples behind m_samples
+    size_t m_sampleCount;
+    
+    // Current position in the buffer, advanced only by readSamples()
+    std::atomic<size_t> m_position;
     
     // Sample rate
     int m_sampleRate;
@@ -42,8 +75,8 @@ private:
     // Channel count
     int m_channelCount;
     
-    // Mutex for thread safety
-    std::mutex m_mutex;
+    // Background decoder when streaming, null when the whole file is loaded
+    std::unique_ptr<StreamDecoder> m_streamDecoder;
 };
 
 #endif // AUDIO_BUFFER_H
\ No newline at end of file
@@ -4,13 +4,12 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <memory>
-#include <mutex>
-#include <memory>
+#include <cstdint>
 #include <portaudio.h>
-#include <memory>
+#include "audio/channel_layout.h"
 
 class AudioBuffer;
+class SampleRing;
 
 class AudioManager {
 public:
@@ -23,13 +22,14 @@ public:
     // Shutdown and cleanup
     void shutdown();
 
-    // Load an audio file for playback
-    bool loadFile(const std::string& filePath);
+    // Load an audio file for playback, optionally streaming it from disk
+    bool loadFile(const std::string& filePath, bool streaming = false);
     
-    // Start microphone input capture
-    bool startInputCapture();
+    // Open input capture with the given number of channels, limited to
+    // what the input device offers. Capture starts with play().
+    bool openInputCapture(int channels = 2);
     
-    // Start playback of loaded audio
+    // Start playback of loaded audio, or capture of the opened input
     bool play();
     
     // Pause playback
@@ -41,12 +41,33 @@ public:
     // Get the current audio samples for visualization
     std::vector<float> getAudioSamples();
     
+    // Read every sample published since the last call, in order, into samples
+    size_t readNewSamples(std::vector<float>& samples);
+    
+    // Copy the newest callback-sized block into samples without consuming it
+    size_t getLatestSamples(std::vector<float>& samples);
+    
+    // Get the number of frames per callback block
+    int getBufferSize() const;
+    
+    // Get the ring the audio callback publishes samples into
+    SampleRing& getSampleRing();
+    
+    // Number of callback blocks that were partly dropped because the ring was full
+    uint64_t getOverrunCount() const;
+    
+    // Number of reads that found fewer samples than requested
+    uint64_t getUnderrunCount() const;
+    
     // Get the sample rate
     int getSampleRate() const;
     
     // Get the number of channels
     int getChannelCount() const;
     
+    // Get the layout of the interleaved channels
+    ChannelLayout getChannelLayout() const;
+    
     // Callback for PortAudio
     static int audioCallback(
         const void* inputBuffer,
@@ -85,11 +106,8 @@ private:
     // Flag to indicate if we're playing
     bool m_isPlaying;
     
-    // Current audio samples for visualization
-    std::vector<float> m_currentSamples;
-    
-    // Mutex for thread safety
-    std::mutex m_mutex;
+    // Lock-free ring between the audio callback and the main loop
+    std::unique_ptr<SampleRing> m_sampleRing;
 };
 
 #endif // AUDIO_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef CHANNEL_LAYOUT_H
+#define CHANNEL_LAYOUT_H
+
+#include <string>
+#include <vector>
+
+// Meaning of the channels of an interleaved stream. Layouts for the common
+// channel counts follow the WAVE/SMPTE order (front left, front right,
+// centre, LFE, ...); any other count gets numbered channels.
+struct ChannelLayout {
+    // Number of interleaved channels
+    int channels = 2;
+
+    // Channels treated as left and right for mid/side analysis, -1 if the
+    // layout has no such pair
+    int left = 0;
+    int right = 1;
+
+    // Short name of each channel, for logs
+    std::vector<std::string> names;
+
+    // Conventional layout for a channel count
+    static ChannelLayout forChannelCount(int channels);
+
+    // Check if the layout has a left/right pair
+    bool hasStereoPair() const;
+
+    // Names joined for logging, e.g. "FL FR C LFE"
+    std::string describe() const;
+};
+
+#endif // CHANNEL_LAYOUT_H
@@ -0,0 +1,71 @@
+#ifndef PCM_CACHE_H
+#define PCM_CACHE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// On-disk cache of decoded PCM, one file per source track. Each entry is a
+// fixed header followed by raw interleaved float32 samples, keyed by the
+// source path and validated against its size and modification time. Entries
+// are memory-mapped read-only, so reloading a track costs only page faults
+// and several visualizer processes share the same pages. The cache is capped
+// in total size: each store evicts the least recently used entries, where a
+// hit counts as a use.
+class PcmCache {
+public:
+    PcmCache();
+    ~PcmCache();
+
+    // Map the cache entry for a source file, returns false on a miss or stale entry
+    bool open(const std::string& sourcePath);
+
+    // Unmap the current entry
+    void close();
+
+    // Write decoded samples for a source file into the cache, evicting old
+    // entries to stay within the size cap
+    static bool store(
+        const std::string& sourcePath,
+        const float* samples,
+        size_t sampleCount,
+        int sampleRate,
+        int channelCount
+    );
+
+    // Get the mapped samples (valid until close)
+    const float* getSamples() const;
+
+    // Get the number of mapped samples
+    size_t getSampleCount() const;
+
+    // Get the sample rate of the cached track
+    int getSampleRate() const;
+
+    // Get the channel count of the cached track
+    int getChannelCount() const;
+
+private:
+    // Get the cache file path for a source file
+    static std::string getCachePath(const std::string& sourcePath);
+
+    // Start of the mapping
+    void* m_mapping;
+
+    // Length of the mapping in bytes
+    size_t m_mappingSize;
+
+    // Samples inside the mapping
+    const float* m_samples;
+
+    // Number of samples inside the mapping
+    size_t m_sampleCount;
+
+    // Sample rate
+    int m_sampleRate;
+
+    // Channel count
+    int m_channelCount;
+};
+
+#endif // PCM_CACHE_H
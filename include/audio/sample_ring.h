@@ -0,0 +1,78 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Wait-free single-producer/single-consumer ring of interleaved samples.
+// The producer (normally the PortAudio callback) never blocks or allocates:
+// when the consumer has fallen a full ring behind, a block that does not fit
+// is dropped whole (so interleaved frames stay aligned) and counted as an
+// overrun. Positions are absolute sample counts since the last reset, so the
+// consumer can read by position.
+class SampleRing {
+public:
+    // Capacity is rounded up to the next power of two
+    explicit SampleRing(size_t capacity);
+    ~SampleRing();
+
+    // Producer: append a block of samples, returns count, or 0 if it was dropped
+    size_t write(const float* samples, size_t count);
+
+    // Producer: number of samples that can be written without dropping
+    size_t getWriteAvailable() const;
+
+    // Consumer: copy up to count samples from the read position and advance it
+    size_t read(float* dest, size_t count);
+
+    // Consumer: copy the newest count samples and move the read position to the end
+    size_t readLatest(float* dest, size_t count);
+
+    // Consumer: copy the newest count samples without moving the read position
+    size_t peekLatest(float* dest, size_t count);
+
+    // Consumer: number of samples written but not yet read
+    size_t getReadAvailable() const;
+
+    // Total samples written since the last reset
+    uint64_t getWritePosition() const;
+
+    // Total samples consumed since the last reset
+    uint64_t getReadPosition() const;
+
+    // Ring capacity in samples
+    size_t getCapacity() const;
+
+    // Number of writes that had to drop samples because the ring was full
+    uint64_t getOverrunCount() const;
+
+    // Number of reads that asked for more samples than were available
+    uint64_t getUnderrunCount() const;
+
+    // Clear contents and counters (only while no producer is running)
+    void reset();
+
+private:
+    // Copy count samples out of the ring starting at an absolute position
+    void copyOut(uint64_t position, float* dest, size_t count) const;
+
+    // Sample storage
+    std::vector<float> m_buffer;
+
+    // Capacity - 1, used to wrap absolute positions
+    size_t m_mask;
+
+    // Producer-owned position, kept on its own cache line
+    alignas(64) std::atomic<uint64_t> m_writePosition;
+
+    // Consumer-owned position, kept on its own cache line
+    alignas(64) std::atomic<uint64_t> m_readPosition;
+
+    // Diagnostics counters
+    alignas(64) std::atomic<uint64_t> m_overrunCount;
+    std::atomic<uint64_t> m_underrunCount;
+};
+
+#endif // SAMPLE_RING_H
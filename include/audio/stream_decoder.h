@@ -0,0 +1,100 @@
+#ifndef STREAM_DECODER_H
+#define STREAM_DECODER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#ifdef USE_LIBSNDFILE
+#include <sndfile.h>
+#endif
+
+class SampleRing;
+
+// Decodes an audio file in fixed-size chunks on a background thread into a
+// bounded prefetch ring, so memory use depends on the prefetch depth rather
+// than on the track length. The reader thread is the ring's only producer
+// and the audio callback is its only consumer.
+class StreamDecoder {
+public:
+    StreamDecoder();
+    ~StreamDecoder();
+
+    // Open a file, decode the first chunk and start the reader thread
+    bool open(const std::string& filePath, size_t chunkFrames, size_t prefetchChunks);
+
+    // Stop the reader thread and close the file
+    void close();
+
+    // Copy up to numSamples decoded samples into dest (real-time safe)
+    size_t readSamples(float* dest, size_t numSamples);
+
+    // Seek back to the start of the file (only while nobody is reading)
+    bool rewind();
+
+    // True once the whole file has been decoded and consumed
+    bool isFinished() const;
+
+    // Get the sample rate
+    int getSampleRate() const;
+
+    // Get the number of channels
+    int getChannelCount() const;
+
+    // Get the total number of frames in the file
+    int64_t getFrameCount() const;
+
+private:
+    // Reader thread body
+    void readerLoop();
+
+    // Decode one chunk into the ring, returns false at end of file
+    bool decodeChunk();
+
+    // Start and stop the reader thread
+    void startReader();
+    void stopReader();
+
+#ifdef USE_LIBSNDFILE
+    // Open sound file handle
+    SNDFILE* m_file;
+#endif
+
+    // Prefetch queue between the reader thread and the audio callback
+    std::unique_ptr<SampleRing> m_ring;
+
+    // Scratch buffer for one decoded chunk
+    std::vector<float> m_chunk;
+
+    // Frames decoded per chunk
+    size_t m_chunkFrames;
+
+    // Sample rate
+    int m_sampleRate;
+
+    // Channel count
+    int m_channelCount;
+
+    // Total frames in the file
+    int64_t m_frameCount;
+
+    // Reader thread
+    std::thread m_readerThread;
+
+    // Reader thread keeps running while set
+    std::atomic<bool> m_running;
+
+    // Set once the last chunk has been decoded
+    std::atomic<bool> m_endOfFile;
+
+    // Lets close() wake the reader thread early
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+};
+
+#endif // STREAM_DECODER_H
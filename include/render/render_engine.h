@@ -3,11 +3,37 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
 
 // Forward declarations
 struct GLFWwindow;
 class ShaderManager;
 
+// Work the renderer submitted to the GPU for one frame
+struct RenderStats {
+    // glDrawArrays calls issued
+    int drawCalls = 0;
+
+    // Vertices drawn from the vertex stream
+    int vertices = 0;
+
+    // Instanced circles drawn
+    int circles = 0;
+
+    // Vertex data copied into the VBO
+    size_t bytesUploaded = 0;
+};
+
+// 2D renderer. The draw functions only append triangles to a CPU-side
+// vertex arena; the arena goes to the GPU in one upload and one draw call
+// when the frame ends (or earlier, in a few large batches, if a frame
+// outgrows it). drawCircleInstanced takes a second path for large numbers
+// of circles: 16 bytes per circle into an instance arena, drawn as
+// instances of one static unit-circle mesh. Switching between the two
+// paths flushes the other one, so primitives are still drawn in the order
+// they were submitted.
 class RenderEngine {
 public:
     RenderEngine();
@@ -22,8 +48,17 @@ public:
     // Begin frame rendering
     void beginFrame();
     
-    // End frame rendering
+    // End frame rendering: draw everything batched and present
     void endFrame();
+
+    // Draw the batched primitives now
+    void flush();
+
+    // Counters of the last finished frame
+    const RenderStats& getFrameStats() const;
+
+    // Set the window title
+    void setTitle(const std::string& title);
     
     // Check if the window should close
     bool shouldClose() const;
@@ -50,12 +85,39 @@ public:
     void drawPoints(const float* points, int count, float size, 
                     float r, float g, float b, float a);
 
+    // Circle drawn as an instance of the shared unit-circle mesh, for
+    // particles and other circles drawn by the thousand
+    void drawCircleInstanced(float x, float y, float radius,
+                             float r, float g, float b, float a);
+
 private:
     // Initialize OpenGL
     bool initializeOpenGL();
     
     // Create shaders
     bool createShaders();
+
+    // Create the unit-circle mesh and the VAO for circle instances
+    void createCircleMesh();
+
+    // Load the window's orthographic projection into a program
+    void setProjection(unsigned int program);
+
+    // Draw the batched triangles or circle instances now
+    void flushVertices();
+    void flushCircles();
+
+    // Make sure a VBO holds at least bytes, orphaning its old storage
+    static void orphanBuffer(size_t bytes, size_t& capacity);
+
+    // Make room for count more vertices and return where they go
+    float* appendVertices(int count);
+
+    // Write one vertex (position and color)
+    static float* writeVertex(float* out, float x, float y, float r, float g, float b, float a);
+
+    // Cosine/sine pairs around the unit circle for a segment count
+    const float* getUnitCircle(int segments);
     
     // GLFW window
     GLFWwindow* m_window;
@@ -75,6 +137,39 @@ private:
     
     // Current shader program
     unsigned int m_currentShader;
+
+    // Size of the VBO's storage in bytes
+    size_t m_vboCapacity;
+
+    // Instanced circle program
+    unsigned int m_circleShader;
+
+    // VAO, static unit-circle mesh and per-instance VBO for circles
+    unsigned int m_circleVao;
+    unsigned int m_circleMeshVbo;
+    unsigned int m_circleInstanceVbo;
+    size_t m_circleInstanceCapacity;
+
+    // One circle instance: centre, radius and RGBA8 colour
+    struct CircleInstance {
+        float x, y;
+        float radius;
+        uint8_t color[4];
+    };
+
+    // Circle instances batched since the last flush
+    std::vector<CircleInstance> m_circles;
+
+    // Vertices batched since the last flush, 6 floats each (x, y, r, g, b, a)
+    std::vector<float> m_vertices;
+
+    // Unit circle cached for the last segment count drawn
+    std::vector<float> m_unitCircle;
+    int m_unitCircleSegments;
+
+    // Counters of the frame in progress and the last finished one
+    RenderStats m_stats;
+    RenderStats m_frameStats;
 };
 
 #endif // RENDER_ENGINE_H
\ No newline at end of file
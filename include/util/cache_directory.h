@@ -0,0 +1,11 @@
+#ifndef CACHE_DIRECTORY_H
+#define CACHE_DIRECTORY_H
+
+#include <string>
+
+// Get the per-user cache directory for the visualizer, creating it if needed.
+// Uses $XDG_CACHE_HOME/musicvis, falling back to ~/.cache/musicvis.
+// Returns an empty string if no usable directory exists.
+std::string getCacheDirectory();
+
+#endif // CACHE_DIRECTORY_H
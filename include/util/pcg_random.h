@@ -0,0 +1,49 @@
+#ifndef PCG_RANDOM_H
+#define PCG_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// PCG32 random number generator (O'Neill, pcg-random.org): 64-bit LCG
+// state with a permuted 32-bit output. Eight bytes of state and a few
+// instructions per draw, against 2.5 KB for std::mt19937. A seed picks the
+// position in the sequence and a stream picks one of 2^63 independent
+// sequences, so threads or tasks that each take their own stream number
+// draw reproducible, uncorrelated values without sharing any state.
+// Instances are not thread-safe; give every thread its own.
+class PcgRandom {
+public:
+    // Generator for the given seed and stream
+    explicit PcgRandom(uint64_t seed = 0, uint64_t stream = 0);
+
+    // Restart the generator at a seed and stream
+    void seed(uint64_t seed, uint64_t stream = 0);
+
+    // Next 32 random bits
+    uint32_t next();
+
+    // Uniform float in [0, 1)
+    float uniform();
+
+    // Uniform float in [low, high)
+    float uniform(float low, float high);
+
+    // Fill count floats with uniforms in [0, 1) or [low, high), the same
+    // values count calls to uniform() would return
+    void fill(float* out, size_t count);
+    void fill(float* out, size_t count, float low, float high);
+    void fill(std::vector<float>& out);
+
+    // Seed from the system's entropy source, for runs that need not repeat
+    static uint64_t randomSeed();
+
+private:
+    // LCG state
+    uint64_t m_state;
+
+    // LCG increment, odd; selects the stream
+    uint64_t m_increment;
+};
+
+#endif // PCG_RANDOM_H
@@ -0,0 +1,69 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+// Small pool of persistent worker threads for fork-join loops. parallelFor
+// hands out indices from a shared counter to the workers and the calling
+// thread, and returns once every index is done, so the caller never waits
+// on a thread being created. Workers sleep on a condition variable between
+// loops. Only one thread may call parallelFor at a time.
+class ThreadPool {
+public:
+    ThreadPool();
+    ~ThreadPool();
+
+    // Start workerCount threads; 0 runs every loop on the calling thread
+    bool start(int workerCount);
+
+    // Stop and join the workers
+    void stop();
+
+    // Run task(index, thread) for every index in [0, count). thread is in
+    // [0, getThreadCount()), 0 being the calling thread, and no two calls
+    // with the same thread value overlap.
+    void parallelFor(size_t count, const std::function<void(size_t, int)>& task);
+
+    // Workers plus the calling thread
+    int getThreadCount() const;
+
+private:
+    // Worker body
+    void workerLoop(int thread);
+
+    // Take indices of the current loop until none are left
+    void runTasks(int thread);
+
+    // Worker threads
+    std::vector<std::thread> m_workers;
+
+    // Guards everything below except m_next
+    std::mutex m_mutex;
+
+    // Wakes the workers for a new loop, and the caller when they are done
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    // Current loop
+    const std::function<void(size_t, int)>* m_task;
+    size_t m_count;
+    std::atomic<size_t> m_next;
+
+    // Workers still busy with the current loop
+    int m_active;
+
+    // Incremented for every loop so sleeping workers see a new one
+    uint64_t m_generation;
+
+    // Set when the workers should exit
+    bool m_stopping;
+};
+
+#endif // THREAD_POOL_H
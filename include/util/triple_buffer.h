@@ -0,0 +1,79 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer triple buffer. The producer
+// fills the write slot and publishes it, the consumer switches to the newest
+// published slot whenever it likes; neither side ever waits for the other.
+// Values the consumer did not pick up in time are overwritten, so it always
+// sees the latest one. Slots are reused, so a value type whose storage is
+// sized once (e.g. vectors assigned the same length) never allocates again.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+        : m_writeIndex(0)
+        , m_readIndex(1)
+        , m_middle(2)
+    {
+    }
+
+    // Producer: slot to fill before the next publish
+    T& getWriteBuffer() {
+        return m_slots[m_writeIndex].value;
+    }
+
+    // Producer: make the write slot the newest value and take a free slot
+    void publish() {
+        uint8_t previous = m_middle.exchange(m_writeIndex | kFreshBit, std::memory_order_acq_rel);
+        m_writeIndex = previous & kIndexMask;
+    }
+
+    // Consumer: switch to the newest published value, returns false if
+    // nothing was published since the last switch
+    bool update() {
+        if (!(m_middle.load(std::memory_order_relaxed) & kFreshBit)) {
+            return false;
+        }
+        uint8_t previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & kIndexMask;
+        return true;
+    }
+
+    // Consumer: slot picked up by the last update
+    T& getReadBuffer() {
+        return m_slots[m_readIndex].value;
+    }
+
+    // Consumer: slot picked up by the last update
+    const T& getReadBuffer() const {
+        return m_slots[m_readIndex].value;
+    }
+
+private:
+    // Middle slot flag set by publish and cleared by update
+    static constexpr uint8_t kFreshBit = 0x4;
+    static constexpr uint8_t kIndexMask = 0x3;
+
+    // Slot on its own cache lines so the two sides never share one
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    // Value storage
+    std::array<Slot, 3> m_slots;
+
+    // Producer-owned slot index
+    alignas(64) uint8_t m_writeIndex;
+
+    // Consumer-owned slot index
+    alignas(64) uint8_t m_readIndex;
+
+    // Index of the slot between the two sides, plus the fresh flag
+    alignas(64) std::atomic<uint8_t> m_middle;
+};
+
+#endif // TRIPLE_BUFFER_H
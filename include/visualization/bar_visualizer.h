@@ -14,12 +14,7 @@ public:
     bool initialize() override;
     
     // Update visualizer state with new audio data
-    void update(
-        float deltaTime,
-        const std::vector<float>& audioData,
-        const std::vector<float>& frequencyData,
-        bool beatDetected
-    ) override;
+    void update(float deltaTime, const AnalysisFrame& frame) override;
     
     // Render the visualization
     void render() override;
@@ -46,6 +41,9 @@ private:
     // Beat color
     std::array<float, 4> m_beatColor;
     
+    // Color of bands that are wide in the stereo image
+    std::array<float, 4> m_wideColor;
+    
     // Bar width
     float m_barWidth;
     
@@ -60,6 +58,9 @@ private:
     
     // Beat intensity
     float m_beatIntensity;
+    
+    // Decaying pulse per drum band (kick, snare, hi-hat)
+    std::array<float, 3> m_bandIntensity;
 };
 
 #endif // BAR_VISUALIZER_H
\ No newline at end of file
@@ -0,0 +1,142 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class ThreadPool;
+class PcgRandom;
+
+// Forces and bounds applied by one simulation step
+struct ParticleStep {
+    // Seconds to advance
+    float deltaTime = 0.0f;
+
+    // Downward acceleration (pixels / s^2)
+    float gravity = 0.0f;
+
+    // Velocity kept per step (1 = no drag)
+    float drag = 1.0f;
+
+    // Life taken from every particle
+    float lifeDrain = 0.0f;
+
+    // Walls the particles bounce off, from (0, 0) to (width, height)
+    float width = 0.0f;
+    float height = 0.0f;
+};
+
+// One particle to add, with the arguments spawn() takes
+struct ParticleSpawn {
+    float x = 0.0f;
+    float y = 0.0f;
+    float vx = 0.0f;
+    float vy = 0.0f;
+    float size = 0.0f;
+    float life = 0.0f;
+    float r = 0.0f;
+    float g = 0.0f;
+    float b = 0.0f;
+    float a = 0.0f;
+};
+
+// Particle store laid out as a structure of arrays: one contiguous array
+// per field, so the update kernel streams through exactly the fields it
+// touches with full-width vector loads, and rendering reads positions,
+// sizes and colours without dragging velocities through the cache. Dead
+// particles are removed by moving the last particle into their slot, so
+// particle order is not stable but removal is O(dead) instead of O(n).
+//
+// With a thread pool, update() splits the particles into fixed-size chunks
+// that the workers step independently, each collecting its dead into its
+// own list. The lists are merged in chunk order, so the result does not
+// depend on the thread count or on which thread took which chunk.
+// spawnBatch() works the same way: every chunk of new particles is built
+// into its own buffer from its own random stream, and the buffers are
+// appended in chunk order once all of them are done.
+class ParticleSystem {
+public:
+    ParticleSystem();
+    ~ParticleSystem();
+
+    // Allocate room for capacity particles and clear the system. pool may
+    // be null to step every particle on the calling thread.
+    void initialize(size_t capacity, std::shared_ptr<ThreadPool> pool = nullptr);
+
+    // Add a particle, returns false when the system is full
+    bool spawn(float x, float y, float vx, float vy, float size, float life,
+               float r, float g, float b, float a);
+
+    // Add count particles built by make(index, random, particle), with
+    // indices in [0, count). Indices are split into fixed-size chunks and
+    // each chunk draws from PcgRandom(seed, chunk), so the new particles
+    // depend only on seed and make, never on the thread count. Particles
+    // past the capacity are dropped. Returns the number added.
+    size_t spawnBatch(size_t count, uint64_t seed,
+                      const std::function<void(size_t, PcgRandom&, ParticleSpawn&)>& make);
+
+    // Integrate, bounce off the walls, drain life and drop dead particles
+    void update(const ParticleStep& step);
+
+    // Remove every particle
+    void clear();
+
+    // Live particles and the capacity
+    size_t size() const;
+    size_t capacity() const;
+
+    // Field arrays, size() entries each
+    const float* getX() const;
+    const float* getY() const;
+    const float* getVelocityX() const;
+    const float* getVelocityY() const;
+    const float* getSize() const;
+    const float* getLife() const;
+    const float* getMaxLife() const;
+    const float* getRed() const;
+    const float* getGreen() const;
+    const float* getBlue() const;
+    const float* getAlpha() const;
+
+private:
+    // Step the particles in [begin, end) and append the indices of the
+    // ones that died to dead, in ascending order
+    void integrate(size_t begin, size_t end, const ParticleStep& step, std::vector<uint32_t>& dead);
+
+    // Fill the slots of dead particles from the end, walking the chunks'
+    // lists (ascending indices, chunks in order) backwards
+    void compact();
+
+    // Move the particle in slot from into slot to
+    void move(size_t from, size_t to);
+
+    // Live particles
+    size_t m_count;
+
+    // Fields
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_vx;
+    std::vector<float> m_vy;
+    std::vector<float> m_size;
+    std::vector<float> m_life;
+    std::vector<float> m_maxLife;
+    std::vector<float> m_red;
+    std::vector<float> m_green;
+    std::vector<float> m_blue;
+    std::vector<float> m_alpha;
+
+    // Workers for large updates
+    std::shared_ptr<ThreadPool> m_pool;
+
+    // Indices of the particles that died in the last update, per chunk
+    std::vector<std::vector<uint32_t>> m_chunkDead;
+
+    // Particles built by the last spawnBatch, per chunk
+    std::vector<std::vector<ParticleSpawn>> m_spawnBuffers;
+};
+
+#endif // PARTICLE_SYSTEM_H
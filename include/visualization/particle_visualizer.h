@@ -4,32 +4,27 @@
 #include <vector>
 #include <array>
 #include "visualization/visualizer.h"
+#include "visualization/particle_system.h"
+#include "util/pcg_random.h"
 
-// Particle structure
-struct Particle {
-    float x, y;          // Position
-    float vx, vy;        // Velocity
-    float size;          // Size
-    float life;          // Lifetime (0.0 - 1.0)
-    float maxLife;       // Maximum lifetime
-    std::array<float, 4> color;  // Color (RGBA)
-};
+class ThreadPool;
 
 class ParticleVisualizer : public Visualizer {
 public:
-    ParticleVisualizer(std::shared_ptr<RenderEngine> renderEngine);
+    // workerPool may be null to simulate on the calling thread. seed fixes
+    // the random sequence, so a seed and the same audio replay a run.
+    // maxParticles caps the live particles; bursts beyond it are cut short.
+    ParticleVisualizer(std::shared_ptr<RenderEngine> renderEngine,
+                       std::shared_ptr<ThreadPool> workerPool = nullptr,
+                       uint64_t seed = 0,
+                       int maxParticles = 800);
     ~ParticleVisualizer();
 
     // Initialize the visualizer
     bool initialize() override;
     
     // Update visualizer state with new audio data
-    void update(
-        float deltaTime,
-        const std::vector<float>& audioData,
-        const std::vector<float>& frequencyData,
-        bool beatDetected
-    ) override;
+    void update(float deltaTime, const AnalysisFrame& frame) override;
     
     // Render the visualization
     void render() override;
@@ -38,7 +33,23 @@ public:
     const char* getName() const override;
 
 private:
-    // Spawn new particles
+    // A burst of particles requested during update()
+    struct Emission {
+        // Index of the burst's first particle in the frame's batch
+        size_t first;
+        
+        // Emission point
+        float x;
+        float y;
+        
+        // Energy behind the burst
+        float energy;
+        
+        // Colour before per-particle variation
+        std::array<float, 4> color;
+    };
+    
+    // Request new particles, built at the end of the frame
     void spawnParticles(
         int count, 
         float x, 
@@ -47,11 +58,22 @@ private:
         const std::array<float, 4>& baseColor = {0.2f, 0.5f, 1.0f, 1.0f}
     );
     
+    // Build the particles requested this frame on the workers and add them
+    void flushEmissions();
+    
+    // Fill one particle of an emission from its chunk's random stream.
+    // Reads only state fixed for the frame, so workers may call it at once.
+    void buildParticle(const Emission& emission, int width, int height,
+                       PcgRandom& random, ParticleSpawn& particle) const;
+    
     // Update particles
     void updateParticles(float deltaTime);
     
     // Particles
-    std::vector<Particle> m_particles;
+    ParticleSystem m_particles;
+    
+    // Workers for the particle update, may be null
+    std::shared_ptr<ThreadPool> m_workerPool;
     
     // Maximum number of particles
     int m_maxParticles;
@@ -81,8 +103,8 @@ private:
     // Beat intensity
     float m_beatIntensity;
     
-    // Last frequency data for visualization
-    std::vector<float> m_lastFrequencyData;
+    // Last band data for visualization
+    std::vector<float> m_lastBandData;
     
     // Low frequency energy
     float m_bassEnergy;
@@ -98,6 +120,16 @@ private:
     
     // Total time elapsed
     float m_totalTime;
+    
+    // Seed and generator for every random choice the visualizer makes
+    uint64_t m_seed;
+    PcgRandom m_random;
+    
+    // Bursts requested this frame, in request order
+    std::vector<Emission> m_emissions;
+    
+    // Particles requested this frame
+    size_t m_pendingParticles;
 };
 
 #endif // PARTICLE_VISUALIZER_H
\ No newline at end of file
@@ -3,11 +3,20 @@
 
 #include <vector>
 #include <memory>
+#include <cstdint>
 #include "visualization/visualizer.h"
 
+class ThreadPool;
+
 class VisualizationManager {
 public:
-    VisualizationManager(std::shared_ptr<RenderEngine> renderEngine);
+    // workerPool, if given, is shared by visualizers with parallel updates;
+    // seed fixes the visualizers' random sequences; maxParticles caps the
+    // particle visualizer
+    VisualizationManager(std::shared_ptr<RenderEngine> renderEngine,
+                         std::shared_ptr<ThreadPool> workerPool = nullptr,
+                         uint64_t seed = 0,
+                         int maxParticles = 800);
     ~VisualizationManager();
 
     // Initialize the visualization manager
@@ -16,13 +25,8 @@ public:
     // Shutdown and cleanup
     void shutdown();
     
-    // Update the current visualizer with new audio data
-    void update(
-        float deltaTime,
-        const std::vector<float>& audioData,
-        const std::vector<float>& frequencyData,
-        bool beatDetected
-    );
+    // Update the current visualizer from the newest analysis frame
+    void update(float deltaTime, const AnalysisFrame& frame);
     
     // Render the current visualization
     void render();
@@ -43,6 +47,15 @@ private:
     // Render engine
     std::shared_ptr<RenderEngine> m_renderEngine;
     
+    // Workers for visualizer updates, may be null
+    std::shared_ptr<ThreadPool> m_workerPool;
+    
+    // Seed handed to visualizers that draw random numbers
+    uint64_t m_seed;
+    
+    // Particle budget for the particle visualizer
+    int m_maxParticles;
+    
     // List of available visualizers
     std::vector<std::unique_ptr<Visualizer>> m_visualizers;
     
@@ -6,6 +6,7 @@
 
 // Forward declarations
 class RenderEngine;
+struct AnalysisFrame;
 
 // Abstract base class for visualizers
 class Visualizer {
@@ -16,13 +17,8 @@ public:
     // Initialize the visualizer
     virtual bool initialize() = 0;
     
-    // Update visualizer state with new audio data
-    virtual void update(
-        float deltaTime,
-        const std::vector<float>& audioData,
-        const std::vector<float>& frequencyData,
-        bool beatDetected
-    ) = 0;
+    // Update visualizer state from the newest analysis frame
+    virtual void update(float deltaTime, const AnalysisFrame& frame) = 0;
     
     // Render the visualization
     virtual void render() = 0;
@@ -31,6 +27,10 @@ public:
     virtual const char* getName() const = 0;
 
 protected:
+    // Average of the bands between two fractions (0-1) of the band range.
+    // Bands are log-spaced, so equal fractions cover equal musical intervals.
+    static float averageBands(const std::vector<float>& bandData, float start, float end);
+    
     // Shared render engine
     std::shared_ptr<RenderEngine> m_renderEngine;
 };
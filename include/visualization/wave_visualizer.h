@@ -14,12 +14,7 @@ public:
     bool initialize() override;
     
     // Update visualizer state with new audio data
-    void update(
-        float deltaTime,
-        const std::vector<float>& audioData,
-        const std::vector<float>& frequencyData,
-        bool beatDetected
-    ) override;
+    void update(float deltaTime, const AnalysisFrame& frame) override;
     
     // Render the visualization
     void render() override;
@@ -43,6 +38,9 @@ private:
     // Beat color when a beat is detected
     std::array<float, 4> m_beatColor;
     
+    // Base color tinted toward the hue of the dominant pitch class
+    std::array<float, 4> m_toneColor;
+    
     // Wave amplitude
     float m_amplitude;
     
@@ -0,0 +1,205 @@
+#include <chrono>
+#include <iostream>
+#include <system_error>
+#include "analysis/analysis_thread.h"
+#include "analysis/fft_analyzer.h"
+#include "analysis/filterbank.h"
+#include "analysis/feature_extractor.h"
+#include "analysis/constant_q_analyzer.h"
+#include "analysis/multichannel_analyzer.h"
+#include "audio/audio_manager.h"
+
+// How long the thread sleeps when the capture has nothing new, well below
+// the duration of one audio callback block
+static const std::chrono::microseconds kIdleSleep(500);
+
+AnalysisThread::AnalysisThread(
+    std::shared_ptr<AudioManager> audioManager,
+    std::shared_ptr<FFTAnalyzer> fftAnalyzer,
+    std::shared_ptr<BeatDetector> beatDetector,
+    std::shared_ptr<Filterbank> filterbank,
+    std::shared_ptr<FeatureExtractor> featureExtractor,
+    std::shared_ptr<ConstantQAnalyzer> constantQAnalyzer,
+    std::shared_ptr<MultichannelAnalyzer> multichannelAnalyzer
+)
+    : m_audioManager(audioManager)
+    , m_fftAnalyzer(fftAnalyzer)
+    , m_beatDetector(beatDetector)
+    , m_filterbank(filterbank)
+    , m_featureExtractor(featureExtractor)
+    , m_constantQAnalyzer(constantQAnalyzer)
+    , m_multichannelAnalyzer(multichannelAnalyzer)
+    , m_running(false)
+    , m_beatAlgorithm(beatDetector->getAlgorithm())
+    , m_sequence(0)
+    , m_framesAnalyzed(0)
+    , m_beatCount(0)
+    , m_seenBeatCount(0)
+{
+}
+
+AnalysisThread::~AnalysisThread() {
+    stop();
+}
+
+bool AnalysisThread::start() {
+    if (m_running) {
+        return true;
+    }
+
+    m_running = true;
+    try {
+        m_thread = std::thread(&AnalysisThread::run, this);
+    } catch (const std::system_error& e) {
+        std::cerr << "Failed to start analysis thread: " << e.what() << std::endl;
+        m_running = false;
+        return false;
+    }
+
+    return true;
+}
+
+void AnalysisThread::stop() {
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool AnalysisThread::isRunning() const {
+    return m_running;
+}
+
+bool AnalysisThread::acquireFrame() {
+    bool fresh = m_frames.update();
+
+    // The read slot belongs to this thread until the next update, so the
+    // beat flags can be rewritten to cover everything since the last acquire
+    AnalysisFrame& frame = m_frames.getReadBuffer();
+
+    frame.beatDetected = frame.beatCount != m_seenBeatCount;
+    m_seenBeatCount = frame.beatCount;
+
+    m_seenBandBeatCounts.resize(frame.bandBeatCounts.size(), 0);
+    uint32_t beatMask = 0;
+    for (size_t band = 0; band < frame.bandBeatCounts.size(); ++band) {
+        if (frame.bandBeatCounts[band] != m_seenBandBeatCounts[band]) {
+            beatMask |= 1u << band;
+        }
+        m_seenBandBeatCounts[band] = frame.bandBeatCounts[band];
+    }
+    frame.bandBeats.beatMask = beatMask;
+
+    return fresh;
+}
+
+const AnalysisFrame& AnalysisThread::getFrame() const {
+    return m_frames.getReadBuffer();
+}
+
+void AnalysisThread::setBeatAlgorithm(BeatAlgorithm algorithm) {
+    m_beatAlgorithm = algorithm;
+}
+
+BeatAlgorithm AnalysisThread::getBeatAlgorithm() const {
+    return m_beatAlgorithm;
+}
+
+void AnalysisThread::run() {
+    while (m_running) {
+        if (!analyzeNewSamples()) {
+            std::this_thread::sleep_for(kIdleSleep);
+        }
+    }
+}
+
+bool AnalysisThread::analyzeNewSamples() {
+    if (m_beatDetector->getAlgorithm() != m_beatAlgorithm) {
+        m_beatDetector->setAlgorithm(m_beatAlgorithm);
+    }
+
+    if (m_audioManager->readNewSamples(m_newSamples) == 0) {
+        return false;
+    }
+
+    const int channels = m_audioManager->getChannelCount();
+    m_framesAnalyzed += m_newSamples.size() / channels;
+
+    // Feed every new sample to the STFT so each hop is analysed exactly once
+    int hops = m_fftAnalyzer->processAudioData(m_newSamples, channels);
+    for (int hop = 0; hop < hops; ++hop) {
+        m_beatDetector->analyzeSpectrum(m_fftAnalyzer->getFrameLinearSpectrum(hop));
+    }
+    if (!m_fftAnalyzer->isMultiResolutionEnabled()) {
+        m_filterbank->process(m_fftAnalyzer->getSpectrumData());
+    }
+    if (hops > 0) {
+        m_featureExtractor->processSpectrum(m_fftAnalyzer->getLinearSpectrum().data());
+    }
+    m_constantQAnalyzer->processAudioData(m_newSamples.data(), m_newSamples.size() / channels, channels);
+    const bool multichannel = m_multichannelAnalyzer && m_multichannelAnalyzer->getLayout().channels == channels;
+    if (multichannel) {
+        m_multichannelAnalyzer->processAudioData(m_newSamples.data(), m_newSamples.size() / channels);
+    }
+
+    // Everything is written straight into the free slot, whose vectors keep
+    // their capacity from the last time it was used
+    AnalysisFrame& frame = m_frames.getWriteBuffer();
+    m_audioManager->getLatestSamples(frame.samples);
+    frame.channels = channels;
+
+    if (!frame.samples.empty()) {
+        m_beatDetector->analyzeAudio(frame.samples, channels);
+        m_featureExtractor->processSamples(frame.samples.data(), frame.samples.size() / channels, channels);
+    }
+
+    const BandBeatState& bandBeats = m_beatDetector->getBandBeats();
+    if (m_beatDetector->isBeatDetected()) {
+        ++m_beatCount;
+    }
+    m_bandBeatCounts.resize(bandBeats.energies.size(), 0);
+    for (size_t band = 0; band < m_bandBeatCounts.size(); ++band) {
+        if (bandBeats.beatMask & (1u << band)) {
+            ++m_bandBeatCounts[band];
+        }
+    }
+
+    const std::vector<float>& spectrum = m_fftAnalyzer->getSpectrumData();
+    const std::vector<float>& bands = m_fftAnalyzer->isMultiResolutionEnabled()
+        ? m_fftAnalyzer->getMultiResolutionSpectrum()
+        : m_filterbank->getBandData();
+    frame.spectrum.assign(spectrum.begin(), spectrum.end());
+    frame.bands.assign(bands.begin(), bands.end());
+    if (multichannel) {
+        frame.channelSpectra.resize(channels);
+        for (int c = 0; c < channels; ++c) {
+            const std::vector<float>& channelSpectrum = m_multichannelAnalyzer->getChannelSpectrum(c);
+            frame.channelSpectra[c].assign(channelSpectrum.begin(), channelSpectrum.end());
+        }
+        const std::vector<float>& midBands = m_multichannelAnalyzer->getMidBands();
+        const std::vector<float>& sideBands = m_multichannelAnalyzer->getSideBands();
+        const std::vector<float>& correlation = m_multichannelAnalyzer->getCorrelation();
+        frame.midBands.assign(midBands.begin(), midBands.end());
+        frame.sideBands.assign(sideBands.begin(), sideBands.end());
+        frame.correlation.assign(correlation.begin(), correlation.end());
+    }
+    frame.features = m_featureExtractor->getFeatures();
+    const std::vector<float>& semitones = m_constantQAnalyzer->getSemitoneSpectrum();
+    const std::vector<float>& chroma = m_constantQAnalyzer->getChroma();
+    frame.semitones.assign(semitones.begin(), semitones.end());
+    frame.chroma.assign(chroma.begin(), chroma.end());
+    frame.beatDetected = m_beatDetector->isBeatDetected();
+    frame.bandBeats.beatMask = bandBeats.beatMask;
+    frame.bandBeats.energies.assign(bandBeats.energies.begin(), bandBeats.energies.end());
+    frame.beatCount = m_beatCount;
+    frame.bandBeatCounts.assign(m_bandBeatCounts.begin(), m_bandBeatCounts.end());
+    frame.bpm = m_beatDetector->getTempo();
+    frame.beatPhase = m_beatDetector->getBeatPhase();
+    frame.algorithm = m_beatDetector->getAlgorithm();
+    frame.timestamp = static_cast<double>(m_framesAnalyzed) / m_audioManager->getSampleRate();
+    frame.sequence = ++m_sequence;
+
+    m_frames.publish();
+
+    return true;
+}
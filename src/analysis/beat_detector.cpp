@@ -5,92 +5,272 @@
 #include <numeric>
 #include <iostream>
 #include "analysis/beat_detector.h"
+#include "analysis/onset_detector.h"
+#include "analysis/tempo_tracker.h"
+#include "analysis/harmonic_percussive_separator.h"
+#include "analysis/dsp_kernels.h"
+
+// Per-block decay of the recency weighting, matches exp(0.5 * (i - count + 1))
+static const double kHistoryDecay = 0.60653065971263342;  // exp(-0.5)
+
+// Number of downmixed frames used for the derivative energy
+static const size_t kLocalSampleCount = 512;
+
+// Tempo confidence needed before predicted beats replace detected onsets
+static const float kMinTempoConfidence = 0.3f;
+
+// Time constant of the running band statistics in seconds
+static const float kBandStatisticsSeconds = 1.0f;
+
+// Smallest rise over the running mean that counts as a band beat, keeps
+// quiet passages from triggering on noise
+static const float kMinBandRise = 0.02f;
 
 BeatDetector::BeatDetector()
     : m_historySize(43)  // About 1 second at 44.1kHz with 1024 buffer size
+    , m_historyIndex(0)
+    , m_historyCount(0)
+    , m_weightedSum(0.0)
+    , m_weightSum(0.0)
+    , m_oldestWeight(0.0)
+    , m_windowMean(0.0)
+    , m_windowM2(0.0)
+    , m_previousEnergy(0.0f)
     , m_sensitivity(0.3f)
     , m_currentEnergy(0.0f)
     , m_threshold(0.0f)
     , m_beatDetected(false)
     , m_cooldown(0)
     , m_cooldownPeriod(3)  // Reduced from 4 to detect beats more frequently
+    , m_algorithm(BeatAlgorithm::Energy)
+    , m_onsetPending(false)
+    , m_predictedBeatPending(false)
+    , m_sampleRate(0)
+    , m_fftSize(0)
+    , m_hopSize(0)
+    , m_bands(getDefaultBands())
+    , m_bandAlpha(0.0f)
+    , m_pendingBandMask(0)
 {
 }
 
 BeatDetector::~BeatDetector() {
 }
 
-bool BeatDetector::initialize(float sensitivity) {
+bool BeatDetector::initialize(float sensitivity, int historySize) {
     m_sensitivity = std::clamp(sensitivity, 0.05f, 0.5f);
-    m_energyHistory.clear();
+    m_historySize = std::max(4, historySize);
+    m_energyHistory.assign(m_historySize, 0.0f);
+    m_historyIndex = 0;
+    m_historyCount = 0;
+    m_weightedSum = 0.0;
+    m_weightSum = 0.0;
+    m_windowMean = 0.0;
+    m_windowM2 = 0.0;
+    m_previousEnergy = 0.0f;
+    m_oldestWeight = std::pow(kHistoryDecay, m_historySize);
+    m_localSamples.reserve(kLocalSampleCount);
     m_currentEnergy = 0.0f;
     m_threshold = 0.0f;
     m_beatDetected = false;
     m_cooldown = 0;
+    m_onsetPending = false;
+    m_predictedBeatPending = false;
     
     std::cout << "Beat detector initialized with sensitivity: " << m_sensitivity << std::endl;
     
     return true;
 }
 
-void BeatDetector::analyzeAudio(const std::vector<float>& audioData) {
-    if (audioData.empty()) {
-        return;
+bool BeatDetector::initializeOnsetDetection(int sampleRate, int fftSize, int hopSize) {
+    auto onsetDetector = std::make_unique<OnsetDetector>();
+    if (!onsetDetector->initialize(sampleRate, fftSize, hopSize, m_sensitivity)) {
+        std::cerr << "Failed to initialize onset detector" << std::endl;
+        return false;
     }
     
-    // Calculate energy with emphasis on rapid changes (important for drums)
-    m_currentEnergy = calculateEnergy(audioData);
+    // The onset envelope is sampled once per hop
+    auto tempoTracker = std::make_unique<TempoTracker>();
+    if (!tempoTracker->initialize(static_cast<float>(sampleRate) / hopSize)) {
+        std::cerr << "Failed to initialize tempo tracker" << std::endl;
+        return false;
+    }
+    
+    auto separator = std::make_unique<HarmonicPercussiveSeparator>();
+    if (!separator->initialize(sampleRate, fftSize, hopSize)) {
+        std::cerr << "Failed to initialize harmonic/percussive separation" << std::endl;
+        return false;
+    }
     
-    // Store raw audio samples for drum detection
-    std::vector<float> localSamples;
-    int channels = 2; // Assuming stereo
+    m_onsetDetector = std::move(onsetDetector);
+    m_tempoTracker = std::move(tempoTracker);
+    m_separator = std::move(separator);
+    m_percussiveSpectrum.assign(m_separator->getBinCount(), 0.0f);
+    m_onsetPending = false;
+    m_predictedBeatPending = false;
     
-    // Store a subset of samples for analysis
-    for (size_t i = 0; i < audioData.size(); i += channels) {
-        if (localSamples.size() < 512) { // We only need a subset for analysis
-            localSamples.push_back(audioData[i]);
+    m_sampleRate = sampleRate;
+    m_fftSize = fftSize;
+    m_hopSize = hopSize;
+    layoutBands();
+    
+    return true;
+}
+
+bool BeatDetector::setBands(const std::vector<BeatBand>& bands) {
+    if (bands.size() > 32) {
+        std::cerr << "Too many beat bands: " << bands.size() << " (at most 32)" << std::endl;
+        return false;
+    }
+    
+    for (const BeatBand& band : bands) {
+        if (band.lowFrequency < 0.0f || band.highFrequency <= band.lowFrequency) {
+            std::cerr << "Invalid beat band " << band.name << ": "
+                      << band.lowFrequency << " - " << band.highFrequency << " Hz" << std::endl;
+            return false;
         }
     }
     
-    // Calculate derivative (rate of change) - drums have sharp transients
-    float derivativeEnergy = calculateDerivativeEnergy(localSamples);
+    m_bands = bands;
+    layoutBands();
     
-    // Combine energies with emphasis on derivative for drums
-    float combinedEnergy = m_currentEnergy * 0.5f + derivativeEnergy * 0.5f;
+    return true;
+}
+
+std::vector<BeatBand> BeatDetector::getDefaultBands() {
+    return {
+        {"kick", 40.0f, 120.0f, 1.5f, 0.2f},
+        {"snare", 180.0f, 2500.0f, 1.8f, 0.15f},
+        {"hihat", 6000.0f, 16000.0f, 1.5f, 0.08f}
+    };
+}
+
+void BeatDetector::setPredictionLookahead(float seconds) {
+    if (m_tempoTracker) {
+        m_tempoTracker->setLookahead(seconds);
+    }
+}
+
+void BeatDetector::analyzeAudio(const std::vector<float>& audioData, int channels) {
+    if (audioData.empty() || channels < 1) {
+        return;
+    }
+    
+    // The energy algorithm always runs so its history stays warm and
+    // getEnergy stays meaningful in either mode
+    bool energyBeat = detectEnergyBeat(audioData, channels);
+    
+    // Report every band that fired in the hops since the last block
+    m_bandBeats.beatMask = m_pendingBandMask;
+    m_pendingBandMask = 0;
+    
+    // Fire on the tempo clock only while the tempo estimate is trustworthy
+    bool usePrediction = m_algorithm == BeatAlgorithm::Predicted
+        && m_tempoTracker && m_tempoTracker->getConfidence() >= kMinTempoConfidence;
+    
+    if (usePrediction) {
+        m_beatDetected = m_predictedBeatPending;
+    } else if (m_algorithm != BeatAlgorithm::Energy && m_onsetDetector) {
+        // Report any onset found in the hops since the last block
+        m_beatDetected = m_onsetPending;
+    } else {
+        m_beatDetected = energyBeat;
+    }
     
-    // Update energy history
-    m_energyHistory.push_back(combinedEnergy);
-    if (m_energyHistory.size() > m_historySize) {
-        m_energyHistory.pop_front();
+    m_onsetPending = false;
+    m_predictedBeatPending = false;
+}
+
+bool BeatDetector::analyzeSpectrum(const float* magnitudes) {
+    if (!m_onsetDetector || !magnitudes) {
+        return false;
     }
     
-    // Need enough history to detect beats
-    if (m_energyHistory.size() < 4) {
-        m_beatDetected = false;
+    // The engines expect the normalized scale of FFTAnalyzer::getFrameSpectrum
+    m_separator->process(magnitudes);
+    const std::vector<float>& percussive = m_separator->getPercussive();
+    float* spectrum = m_percussiveSpectrum.data();
+    spectrum[0] = percussive[0];
+    dsp::normalizedDecibels(percussive.data() + 1, spectrum + 1, percussive.size() - 1, 96.0f);
+    
+    bool onset = m_onsetDetector->processFrame(spectrum);
+    if (onset) {
+        m_onsetPending = true;
+    }
+    
+    // The flux of every hop is the tempo tracker's onset envelope
+    if (m_tempoTracker->processFrame(m_onsetDetector->getFlux())) {
+        m_predictedBeatPending = true;
+    }
+    
+    m_pendingBandMask |= detectBandBeats(spectrum);
+    
+    return onset;
+}
+
+void BeatDetector::setAlgorithm(BeatAlgorithm algorithm) {
+    if (algorithm != BeatAlgorithm::Energy && !m_onsetDetector) {
+        std::cerr << "Spectral-flux beat detection is not initialized" << std::endl;
         return;
     }
     
-    // Calculate local average energy with exponential decay weighting
-    // This puts more emphasis on recent energy levels
-    float totalWeight = 0.0f;
-    float weightedSum = 0.0f;
+    m_algorithm = algorithm;
+    m_onsetPending = false;
+    m_predictedBeatPending = false;
     
-    int count = m_energyHistory.size();
-    for (int i = 0; i < count; i++) {
-        // Exponential weighting gives more importance to recent samples
-        float weight = std::exp(0.5f * (i - count + 1));
-        weightedSum += m_energyHistory[i] * weight;
-        totalWeight += weight;
+    std::cout << "Beat detection algorithm: " << getAlgorithmName(m_algorithm) << std::endl;
+}
+
+BeatAlgorithm BeatDetector::getAlgorithm() const {
+    return m_algorithm;
+}
+
+const char* BeatDetector::getAlgorithmName(BeatAlgorithm algorithm) {
+    switch (algorithm) {
+        case BeatAlgorithm::SpectralFlux:
+            return "Spectral flux";
+        case BeatAlgorithm::Predicted:
+            return "Predicted (tempo)";
+        case BeatAlgorithm::Energy:
+        default:
+            return "Energy";
     }
+}
+
+bool BeatDetector::detectEnergyBeat(const std::vector<float>& audioData, int channels) {
+    // Calculate energy with emphasis on rapid changes (important for drums)
+    m_currentEnergy = calculateEnergy(audioData);
+    
+    // Downmix the first frames for drum detection, so a drum on any
+    // channel of the layout counts
+    m_localSamples.resize(std::min(kLocalSampleCount, audioData.size() / channels));
+    dsp::downmix(audioData.data(), m_localSamples.data(), m_localSamples.size(), channels);
+    
+    // Calculate derivative (rate of change) - drums have sharp transients
+    float derivativeEnergy = calculateDerivativeEnergy(m_localSamples);
+    
+    // Combine energies with emphasis on derivative for drums
+    float combinedEnergy = m_currentEnergy * 0.5f + derivativeEnergy * 0.5f;
     
-    float averageEnergy = weightedSum / totalWeight;
+    // Update energy history and its running statistics in constant time
+    float previousEnergy = m_previousEnergy;
+    m_previousEnergy = combinedEnergy;
+    pushEnergy(combinedEnergy);
     
-    // Calculate variance for dynamic threshold
-    float variance = 0.0f;
-    for (float e : m_energyHistory) {
-        variance += (e - averageEnergy) * (e - averageEnergy);
+    // Need enough history to detect beats
+    if (m_historyCount < 4) {
+        return false;
     }
-    variance /= m_energyHistory.size();
+    
+    // Local average energy with exponential decay weighting, which puts
+    // more emphasis on recent energy levels
+    float averageEnergy = static_cast<float>(m_weightedSum / m_weightSum);
+    
+    // Variance of the history around that average: the window variance plus
+    // the squared offset between the window mean and the weighted average
+    double meanOffset = m_windowMean - averageEnergy;
+    float variance = static_cast<float>(
+        std::max(0.0, m_windowM2 / m_historyCount + meanOffset * meanOffset));
     
     // Calculate dynamic threshold
     float stdDev = std::sqrt(variance);
@@ -111,8 +291,7 @@ void BeatDetector::analyzeAudio(const std::vector<float>& audioData) {
     // Check if we're in cooldown period
     if (m_cooldown > 0) {
         m_cooldown--;
-        m_beatDetected = false;
-        return;
+        return false;
     }
     
     // Enhanced beat detection logic
@@ -121,7 +300,6 @@ void BeatDetector::analyzeAudio(const std::vector<float>& audioData) {
     // 2. Current energy is significantly higher than previous energy (sharp rise)
     // 3. AND current energy is higher than the local average
     
-    float previousEnergy = m_energyHistory[m_energyHistory.size() - 2];
     float energyRatio = combinedEnergy / (previousEnergy + 0.01f); // Avoid division by zero
     
     bool isEnergyRising = energyRatio > 1.1f; // 10% increase
@@ -129,16 +307,125 @@ void BeatDetector::analyzeAudio(const std::vector<float>& audioData) {
     bool isAboveAverage = combinedEnergy > averageEnergy * 1.1f;
     
     if (isAboveThreshold && isEnergyRising && isAboveAverage) {
-        m_beatDetected = true;
         m_cooldown = m_cooldownPeriod;
         
         // Debug output
-        std::cout << "Beat detected! Energy: " << combinedEnergy 
-                 << " Threshold: " << m_threshold 
-                 << " Ratio: " << energyRatio << std::endl;
+        if (m_algorithm == BeatAlgorithm::Energy) {
+            std::cout << "Beat detected! Energy: " << combinedEnergy 
+                     << " Threshold: " << m_threshold 
+                     << " Ratio: " << energyRatio << std::endl;
+        }
+        return true;
+    }
+    
+    return false;
+}
+
+void BeatDetector::layoutBands() {
+    const size_t bandCount = m_bands.size();
+    
+    m_bandFirstBin.assign(bandCount, 0);
+    m_bandLastBin.assign(bandCount, -1);
+    m_bandThreshold.assign(bandCount, 0.0f);
+    m_bandMean.assign(bandCount, 0.0f);
+    m_bandVariance.assign(bandCount, 0.0f);
+    m_bandPrevious.assign(bandCount, 0.0f);
+    m_bandCooldown.assign(bandCount, 0);
+    m_bandCooldownHops.assign(bandCount, 0);
+    m_bandBeats.beatMask = 0;
+    m_bandBeats.energies.assign(bandCount, 0.0f);
+    m_pendingBandMask = 0;
+    
+    // Bins are only known once the spectrum layout is
+    if (m_sampleRate <= 0 || m_fftSize <= 0 || m_hopSize <= 0) {
+        return;
+    }
+    
+    const float binWidth = static_cast<float>(m_sampleRate) / m_fftSize;
+    const int lastBin = m_fftSize / 2;
+    const float hopSeconds = static_cast<float>(m_hopSize) / m_sampleRate;
+    
+    m_bandAlpha = 1.0f - std::exp(-hopSeconds / kBandStatisticsSeconds);
+    
+    for (size_t band = 0; band < bandCount; ++band) {
+        // Skip the DC bin; bands narrower than a bin still get one bin
+        int first = std::clamp(static_cast<int>(std::ceil(m_bands[band].lowFrequency / binWidth)), 1, lastBin);
+        int last = std::clamp(static_cast<int>(std::floor(m_bands[band].highFrequency / binWidth)), first, lastBin);
+        
+        m_bandFirstBin[band] = first;
+        m_bandLastBin[band] = last;
+        m_bandThreshold[band] = m_bands[band].threshold;
+        m_bandCooldownHops[band] = std::max(1, static_cast<int>(std::lround(m_bands[band].cooldownSeconds / hopSeconds)));
+    }
+}
+
+uint32_t BeatDetector::detectBandBeats(const float* spectrum) {
+    uint32_t mask = 0;
+    const int bandCount = static_cast<int>(m_bandLastBin.size());
+    
+    for (int band = 0; band < bandCount; ++band) {
+        if (m_bandLastBin[band] < m_bandFirstBin[band]) {
+            continue;
+        }
+        
+        // Mean normalized magnitude across the band
+        float sum = 0.0f;
+        for (int bin = m_bandFirstBin[band]; bin <= m_bandLastBin[band]; ++bin) {
+            sum += spectrum[bin];
+        }
+        float energy = sum / (m_bandLastBin[band] - m_bandFirstBin[band] + 1);
+        m_bandBeats.energies[band] = energy;
+        
+        // Fire on a rising value clearly above this band's running mean
+        float mean = m_bandMean[band];
+        float threshold = mean + std::max(kMinBandRise, m_bandThreshold[band] * std::sqrt(m_bandVariance[band]));
+        bool rising = energy > m_bandPrevious[band];
+        
+        if (m_bandCooldown[band] > 0) {
+            --m_bandCooldown[band];
+        } else if (rising && energy > threshold) {
+            mask |= 1u << band;
+            m_bandCooldown[band] = m_bandCooldownHops[band];
+        }
+        
+        // Exponentially weighted mean and variance, constant time per hop
+        float diff = energy - mean;
+        float increment = m_bandAlpha * diff;
+        m_bandMean[band] = mean + increment;
+        m_bandVariance[band] = (1.0f - m_bandAlpha) * (m_bandVariance[band] + diff * increment);
+        m_bandPrevious[band] = energy;
+    }
+    
+    return mask;
+}
+
+void BeatDetector::pushEnergy(float energy) {
+    // Recursive exponential weighting, with the value leaving the window
+    // removed at the weight it has decayed to
+    m_weightedSum = energy + kHistoryDecay * m_weightedSum;
+    m_weightSum = 1.0 + kHistoryDecay * m_weightSum;
+    if (m_historyCount == m_historySize) {
+        m_weightedSum -= m_oldestWeight * m_energyHistory[m_historyIndex];
+        m_weightSum -= m_oldestWeight;
+    }
+    
+    if (m_historyCount < m_historySize) {
+        // Welford update while the window is filling
+        ++m_historyCount;
+        double delta = energy - m_windowMean;
+        m_windowMean += delta / m_historyCount;
+        m_windowM2 += delta * (energy - m_windowMean);
     } else {
-        m_beatDetected = false;
+        // Sliding Welford update replacing the oldest value
+        double oldest = m_energyHistory[m_historyIndex];
+        double previousMean = m_windowMean;
+        m_windowMean += (energy - oldest) / m_historyCount;
+        m_windowM2 += (energy - oldest) * (energy - m_windowMean + oldest - previousMean);
+        m_windowM2 = std::max(0.0, m_windowM2);
     }
+    
+    m_energyHistory[m_historyIndex] = energy;
+    m_historyIndex = (m_historyIndex + 1) % m_historySize;
 }
 
 float BeatDetector::calculateEnergy(const std::vector<float>& audioData) {
@@ -175,4 +462,28 @@ bool BeatDetector::isBeatDetected() const {
 
 float BeatDetector::getEnergy() const {
     return m_currentEnergy;
+}
+
+const BandBeatState& BeatDetector::getBandBeats() const {
+    return m_bandBeats;
+}
+
+const std::vector<BeatBand>& BeatDetector::getBands() const {
+    return m_bands;
+}
+
+float BeatDetector::getTempo() const {
+    return m_tempoTracker ? m_tempoTracker->getBpm() : 0.0f;
+}
+
+float BeatDetector::getBeatPhase() const {
+    return m_tempoTracker ? m_tempoTracker->getBeatPhase() : 0.0f;
+}
+
+float BeatDetector::getTempoConfidence() const {
+    return m_tempoTracker ? m_tempoTracker->getConfidence() : 0.0f;
+}
+
+float BeatDetector::getTimeToNextBeat() const {
+    return m_tempoTracker ? m_tempoTracker->getTimeToNextBeat() : 0.0f;
 }
\ No newline at end of file
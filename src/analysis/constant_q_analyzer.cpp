@@ -0,0 +1,257 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include "analysis/constant_q_analyzer.h"
+#include "analysis/dsp_kernels.h"
+
+// Semitones per octave, also the number of chroma bins
+static const int kBinsPerOctave = 12;
+
+// Kernel weights below this fraction of the note's peak weight are dropped
+static const float kKernelThreshold = 0.01f;
+
+// Range the semitone levels are normalized over, same as the FFT spectrum
+static const float kRangeDb = 96.0f;
+
+// Frequency of a MIDI note in Hz
+static double noteFrequency(int note) {
+    return 440.0 * std::pow(2.0, (note - 69) / static_cast<double>(kBinsPerOctave));
+}
+
+ConstantQAnalyzer::ConstantQAnalyzer()
+    : m_sampleRate(0)
+    , m_fftSize(0)
+    , m_lowestNote(0)
+    , m_noteCount(0)
+{
+}
+
+ConstantQAnalyzer::~ConstantQAnalyzer() {
+}
+
+bool ConstantQAnalyzer::initialize(int sampleRate, int hopSize, int lowestNote, int noteCount) {
+    if (sampleRate <= 0 || noteCount <= 0 || lowestNote < 0
+        || noteFrequency(lowestNote + noteCount - 1) >= sampleRate * 0.5) {
+        std::cerr << "Invalid constant-Q layout: " << noteCount << " notes from MIDI "
+                  << lowestNote << " at " << sampleRate << " Hz" << std::endl;
+        return false;
+    }
+
+    // Q for one bin per semitone; the lowest note has the longest kernel
+    const double q = 1.0 / (std::pow(2.0, 1.0 / kBinsPerOctave) - 1.0);
+    int longestKernel = static_cast<int>(std::ceil(q * sampleRate / noteFrequency(lowestNote)));
+    int fftSize = 1;
+    while (fftSize < longestKernel) {
+        fftSize <<= 1;
+    }
+
+    // The kernel does the windowing, so the FFT must see the raw signal
+    if (!m_fftAnalyzer.initialize(fftSize, std::min(hopSize, fftSize), 1, WindowFunction::Rectangular)) {
+        return false;
+    }
+
+    m_sampleRate = sampleRate;
+    m_fftSize = fftSize;
+    m_lowestNote = lowestNote;
+    m_noteCount = noteCount;
+
+    if (!buildKernel()) {
+        return false;
+    }
+
+    // Bins past the highest kernel never reach a note, so they are not separated
+    int binCount = 0;
+    for (int index = 0; index < noteCount; ++index) {
+        binCount = std::max(binCount, m_kernelFirstBin[index] + m_kernelLength[index]);
+    }
+    if (!m_separator.initialize(sampleRate, fftSize, std::min(hopSize, fftSize), binCount)) {
+        return false;
+    }
+    m_binMagnitudes.assign(binCount, 0.0f);
+    m_harmonicSpectrum.assign(static_cast<size_t>(binCount) * 2, 0.0f);
+
+    m_amplitudes.assign(noteCount, 0.0f);
+    m_semitones.assign(noteCount, 0.0f);
+    m_chroma.assign(kBinsPerOctave, 0.0f);
+
+    std::cout << "Constant-Q analyzer initialized with " << noteCount << " semitones from MIDI "
+              << lowestNote << ", FFT size " << fftSize << ", " << m_kernel.size() / 2
+              << " kernel weights" << std::endl;
+
+    return true;
+}
+
+bool ConstantQAnalyzer::buildKernel() {
+    const int numBins = m_fftSize / 2 + 1;
+    const double q = 1.0 / (std::pow(2.0, 1.0 / kBinsPerOctave) - 1.0);
+
+    fftwf_complex* temporal = static_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * m_fftSize));
+    fftwf_complex* spectral = static_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * m_fftSize));
+    if (!temporal || !spectral) {
+        std::cerr << "Failed to allocate memory for the constant-Q kernel" << std::endl;
+        fftwf_free(temporal);
+        fftwf_free(spectral);
+        return false;
+    }
+
+    // The kernel is built once, so an estimated plan beats a measured one
+    fftwf_plan plan = fftwf_plan_dft_1d(m_fftSize, temporal, spectral, FFTW_FORWARD, FFTW_ESTIMATE);
+    if (!plan) {
+        std::cerr << "Failed to create constant-Q kernel plan" << std::endl;
+        fftwf_free(temporal);
+        fftwf_free(spectral);
+        return false;
+    }
+
+    m_kernelFirstBin.clear();
+    m_kernelLength.clear();
+    m_kernelOffset.clear();
+    m_kernel.clear();
+
+    std::vector<float> magnitudes(numBins);
+    for (int index = 0; index < m_noteCount; ++index) {
+        const double frequency = noteFrequency(m_lowestNote + index);
+        const int length = std::min(m_fftSize, static_cast<int>(std::ceil(q * m_sampleRate / frequency)));
+        const int start = m_fftSize - length;
+
+        // Hamming-windowed complex exponential with unit gain, ending at the
+        // newest sample of the frame
+        double windowSum = 0.0;
+        for (int n = 0; n < length; ++n) {
+            windowSum += 0.54 - 0.46 * std::cos(2.0 * M_PI * n / std::max(1, length - 1));
+        }
+
+        std::fill(reinterpret_cast<float*>(temporal), reinterpret_cast<float*>(temporal + m_fftSize), 0.0f);
+        for (int n = 0; n < length; ++n) {
+            double window = (0.54 - 0.46 * std::cos(2.0 * M_PI * n / std::max(1, length - 1))) / windowSum;
+            double phase = 2.0 * M_PI * frequency * n / m_sampleRate;
+            temporal[start + n][0] = static_cast<float>(window * std::cos(phase));
+            temporal[start + n][1] = static_cast<float>(window * std::sin(phase));
+        }
+
+        fftwf_execute(plan);
+
+        // By Parseval, sum(x * conj(t)) = sum(X * conj(T)) / N. The factor 2
+        // turns the result into the amplitude of a real sinusoid.
+        float peak = 0.0f;
+        for (int bin = 0; bin < numBins; ++bin) {
+            magnitudes[bin] = std::hypot(spectral[bin][0], spectral[bin][1]);
+            peak = std::max(peak, magnitudes[bin]);
+        }
+
+        int firstBin = 0;
+        while (firstBin < numBins - 1 && magnitudes[firstBin] < peak * kKernelThreshold) {
+            ++firstBin;
+        }
+        int lastBin = numBins - 1;
+        while (lastBin > firstBin && magnitudes[lastBin] < peak * kKernelThreshold) {
+            --lastBin;
+        }
+
+        const float scale = 2.0f / m_fftSize;
+        m_kernelFirstBin.push_back(firstBin);
+        m_kernelLength.push_back(lastBin - firstBin + 1);
+        m_kernelOffset.push_back(static_cast<int>(m_kernel.size() / 2));
+        for (int bin = firstBin; bin <= lastBin; ++bin) {
+            m_kernel.push_back(spectral[bin][0] * scale);
+            m_kernel.push_back(-spectral[bin][1] * scale);
+        }
+    }
+
+    fftwf_destroy_plan(plan);
+    fftwf_free(temporal);
+    fftwf_free(spectral);
+
+    return true;
+}
+
+bool ConstantQAnalyzer::processAudioData(const float* audioData, size_t frameCount, int channels) {
+    int hops = m_fftAnalyzer.processAudioData(audioData, frameCount, channels);
+    if (hops == 0) {
+        return false;
+    }
+
+    // Older hops of the block only move the separator's time medians on,
+    // so they keep spanning 0.2 s of audio; the kernel is evaluated on the
+    // newest hop alone, the others are stale
+    for (int hop = 0; hop + 1 < hops; ++hop) {
+        m_separator.advance(m_fftAnalyzer.getFrameLinearSpectrum(hop));
+    }
+    processSpectrum(m_fftAnalyzer.getComplexSpectrum());
+    return true;
+}
+
+void ConstantQAnalyzer::processSpectrum(const fftwf_complex* spectrum) {
+    if (!spectrum || m_amplitudes.empty()) {
+        return;
+    }
+
+    // Keep the harmonic part of every bin the kernel reads. Magnitudes are
+    // scaled like FFTAnalyzer's linear spectra, which the skipped hops feed
+    // into the same medians.
+    const int binCount = m_separator.getBinCount();
+    dsp::magnitude(reinterpret_cast<const float*>(spectrum), m_binMagnitudes.data(), binCount, 2.0f / m_fftSize);
+    m_separator.process(m_binMagnitudes.data());
+    const std::vector<float>& mask = m_separator.getHarmonicMask();
+    for (int bin = 0; bin < binCount; ++bin) {
+        m_harmonicSpectrum[bin * 2] = spectrum[bin][0] * mask[bin];
+        m_harmonicSpectrum[bin * 2 + 1] = spectrum[bin][1] * mask[bin];
+    }
+
+    const float* bins = m_harmonicSpectrum.data();
+    for (int index = 0; index < m_noteCount; ++index) {
+        float re = 0.0f;
+        float im = 0.0f;
+        dsp::complexDotProduct(
+            bins + static_cast<size_t>(m_kernelFirstBin[index]) * 2,
+            m_kernel.data() + static_cast<size_t>(m_kernelOffset[index]) * 2,
+            m_kernelLength[index],
+            re, im
+        );
+        m_amplitudes[index] = std::sqrt(re * re + im * im);
+    }
+
+    dsp::normalizedDecibels(m_amplitudes.data(), m_semitones.data(), m_noteCount, kRangeDb);
+
+    // Fold the octaves onto twelve pitch classes
+    std::fill(m_chroma.begin(), m_chroma.end(), 0.0f);
+    for (int index = 0; index < m_noteCount; ++index) {
+        float amplitude = m_amplitudes[index];
+        m_chroma[(m_lowestNote + index) % kBinsPerOctave] += amplitude * amplitude;
+    }
+
+    float peak = *std::max_element(m_chroma.begin(), m_chroma.end());
+    if (peak > 0.0f) {
+        for (float& value : m_chroma) {
+            value /= peak;
+        }
+    }
+}
+
+const std::vector<float>& ConstantQAnalyzer::getSemitoneSpectrum() const {
+    return m_semitones;
+}
+
+const std::vector<float>& ConstantQAnalyzer::getChroma() const {
+    return m_chroma;
+}
+
+float ConstantQAnalyzer::getNoteFrequency(int index) const {
+    return static_cast<float>(noteFrequency(m_lowestNote + index));
+}
+
+int ConstantQAnalyzer::getLowestNote() const {
+    return m_lowestNote;
+}
+
+int ConstantQAnalyzer::getNoteCount() const {
+    return m_noteCount;
+}
+
+int ConstantQAnalyzer::getFFTSize() const {
+    return m_fftSize;
+}
+
+size_t ConstantQAnalyzer::getKernelSize() const {
+    return m_kernel.size() / 2;
+}
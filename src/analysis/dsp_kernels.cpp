@@ -0,0 +1,477 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "analysis/dsp_kernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace dsp {
+
+// Minimax-style fit of log2(1 + x) on [0, 1), max error about 3e-5
+static const float kLog2C1 = 1.4418255f;
+static const float kLog2C2 = -0.708678912f;
+static const float kLog2C3 = 0.415411186f;
+static const float kLog2C4 = -0.194408323f;
+static const float kLog2C5 = 0.0458789501f;
+
+// 20 * log10(x) = kDecibelsPerOctave * log2(x)
+static const float kDecibelsPerOctave = 6.02059991f;
+
+static const float kMagnitudeFloor = 1e-6f;
+
+// Number of set bits in each 4-bit sign mask
+static const int kMaskBitCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+// Scalar version of the vector log2 so tails match the vector lanes exactly
+static inline float fastLog2(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+    bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+    float mantissa;
+    memcpy(&mantissa, &bits, sizeof(mantissa));
+    float m = mantissa - 1.0f;
+    float poly = kLog2C5;
+    poly = poly * m + kLog2C4;
+    poly = poly * m + kLog2C3;
+    poly = poly * m + kLog2C2;
+    poly = poly * m + kLog2C1;
+    return exponent + poly * m;
+}
+
+#if defined(__AVX2__)
+static inline __m256 fastLog2(__m256 x) {
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 exponent = _mm256_cvtepi32_ps(
+        _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    __m256i mantissaBits = _mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000));
+    __m256 m = _mm256_sub_ps(_mm256_castsi256_ps(mantissaBits), _mm256_set1_ps(1.0f));
+    __m256 poly = _mm256_set1_ps(kLog2C5);
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, m), _mm256_set1_ps(kLog2C4));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, m), _mm256_set1_ps(kLog2C3));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, m), _mm256_set1_ps(kLog2C2));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, m), _mm256_set1_ps(kLog2C1));
+    return _mm256_add_ps(exponent, _mm256_mul_ps(poly, m));
+}
+
+static inline float horizontalSum(__m256 x) {
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half);
+}
+#elif defined(__SSE2__)
+static inline __m128 fastLog2(__m128 x) {
+    __m128i bits = _mm_castps_si128(x);
+    __m128 exponent = _mm_cvtepi32_ps(
+        _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    __m128i mantissaBits = _mm_or_si128(
+        _mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000));
+    __m128 m = _mm_sub_ps(_mm_castsi128_ps(mantissaBits), _mm_set1_ps(1.0f));
+    __m128 poly = _mm_set1_ps(kLog2C5);
+    poly = _mm_add_ps(_mm_mul_ps(poly, m), _mm_set1_ps(kLog2C4));
+    poly = _mm_add_ps(_mm_mul_ps(poly, m), _mm_set1_ps(kLog2C3));
+    poly = _mm_add_ps(_mm_mul_ps(poly, m), _mm_set1_ps(kLog2C2));
+    poly = _mm_add_ps(_mm_mul_ps(poly, m), _mm_set1_ps(kLog2C1));
+    return _mm_add_ps(exponent, _mm_mul_ps(poly, m));
+}
+#endif
+
+#if defined(__SSE2__)
+static inline float horizontalSum(__m128 x) {
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+    return _mm_cvtss_f32(x);
+}
+#endif
+
+void downmix(const float* interleaved, float* mono, size_t frames, int channels) {
+    if (channels == 1) {
+        memcpy(mono, interleaved, frames * sizeof(float));
+        return;
+    }
+
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Stereo is the common case: split even/odd lanes and average them
+    if (channels == 2) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 4 <= frames; i += 4) {
+            __m128 a = _mm_loadu_ps(interleaved + i * 2);
+            __m128 b = _mm_loadu_ps(interleaved + i * 2 + 4);
+            __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(mono + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+        }
+    }
+#endif
+
+    const float scale = 1.0f / channels;
+    for (; i < frames; ++i) {
+        const float* frame = interleaved + i * channels;
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            sum += frame[c];
+        }
+        mono[i] = sum * scale;
+    }
+}
+
+void deinterleave(const float* interleaved, float* const* planar, size_t frames, int channels) {
+    if (channels == 1) {
+        memcpy(planar[0], interleaved, frames * sizeof(float));
+        return;
+    }
+
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Four frames at a time: stereo splits even/odd lanes, four and eight
+    // channels are 4x4 transposes of the frames' channel groups
+    if (channels == 2) {
+        for (; i + 4 <= frames; i += 4) {
+            __m128 a = _mm_loadu_ps(interleaved + i * 2);
+            __m128 b = _mm_loadu_ps(interleaved + i * 2 + 4);
+            _mm_storeu_ps(planar[0] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(planar[1] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    } else if (channels == 4 || channels == 8) {
+        for (; i + 4 <= frames; i += 4) {
+            const float* block = interleaved + i * channels;
+            for (int group = 0; group < channels; group += 4) {
+                __m128 r0 = _mm_loadu_ps(block + group);
+                __m128 r1 = _mm_loadu_ps(block + channels + group);
+                __m128 r2 = _mm_loadu_ps(block + channels * 2 + group);
+                __m128 r3 = _mm_loadu_ps(block + channels * 3 + group);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                _mm_storeu_ps(planar[group] + i, r0);
+                _mm_storeu_ps(planar[group + 1] + i, r1);
+                _mm_storeu_ps(planar[group + 2] + i, r2);
+                _mm_storeu_ps(planar[group + 3] + i, r3);
+            }
+        }
+    }
+#endif
+
+    for (; i < frames; ++i) {
+        const float* frame = interleaved + i * channels;
+        for (int c = 0; c < channels; ++c) {
+            planar[c][i] = frame[c];
+        }
+    }
+}
+
+void multiply(const float* src, const float* window, float* dest, size_t count) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), _mm256_loadu_ps(window + i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(window + i)));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        dest[i] = src[i] * window[i];
+    }
+}
+
+void magnitude(const float* complexPairs, float* dest, size_t count, float scale) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 scaleVec = _mm_set1_ps(scale);
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(complexPairs + i * 2);
+        __m128 b = _mm_loadu_ps(complexPairs + i * 2 + 4);
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 power = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_sqrt_ps(power), scaleVec));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float re = complexPairs[i * 2];
+        float im = complexPairs[i * 2 + 1];
+        dest[i] = std::sqrt(re * re + im * im) * scale;
+    }
+}
+
+void normalizedDecibels(const float* src, float* dest, size_t count, float rangeDb) {
+    const float gain = kDecibelsPerOctave / rangeDb;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 floorVec = _mm256_set1_ps(kMagnitudeFloor);
+    const __m256 gainVec = _mm256_set1_ps(gain);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        __m256 log2Value = fastLog2(_mm256_add_ps(_mm256_loadu_ps(src + i), floorVec));
+        __m256 value = _mm256_add_ps(_mm256_mul_ps(log2Value, gainVec), one);
+        _mm256_storeu_ps(dest + i, _mm256_max_ps(value, zero));
+    }
+#elif defined(__SSE2__)
+    const __m128 floorVec = _mm_set1_ps(kMagnitudeFloor);
+    const __m128 gainVec = _mm_set1_ps(gain);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 log2Value = fastLog2(_mm_add_ps(_mm_loadu_ps(src + i), floorVec));
+        __m128 value = _mm_add_ps(_mm_mul_ps(log2Value, gainVec), one);
+        _mm_storeu_ps(dest + i, _mm_max_ps(value, zero));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float value = fastLog2(src[i] + kMagnitudeFloor) * gain + 1.0f;
+        dest[i] = std::max(0.0f, value);
+    }
+}
+
+float dotProduct(const float* a, const float* b, size_t count) {
+    float sum = 0.0f;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    sum = _mm_cvtss_f32(half);
+#elif defined(__SSE2__)
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = _mm_cvtss_f32(acc);
+#endif
+
+    for (; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void complexDotProduct(const float* a, const float* b, size_t count, float& re, float& im) {
+    float sumRe = 0.0f;
+    float sumIm = 0.0f;
+    size_t i = 0;
+
+    // Lane-wise a * b gives (ar br, ai bi) pairs whose difference is the real
+    // part, a * swapped b gives (ar bi, ai br) pairs whose sum is the imaginary
+#if defined(__AVX2__)
+    __m256 direct = _mm256_setzero_ps();
+    __m256 crossed = _mm256_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m256 x = _mm256_loadu_ps(a + i * 2);
+        __m256 y = _mm256_loadu_ps(b + i * 2);
+        direct = _mm256_add_ps(direct, _mm256_mul_ps(x, y));
+        crossed = _mm256_add_ps(crossed, _mm256_mul_ps(x, _mm256_permute_ps(y, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+    const __m256 alternate = _mm256_setr_ps(1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f);
+    sumRe = horizontalSum(_mm256_mul_ps(direct, alternate));
+    sumIm = horizontalSum(crossed);
+#elif defined(__SSE2__)
+    __m128 direct = _mm_setzero_ps();
+    __m128 crossed = _mm_setzero_ps();
+    for (; i + 2 <= count; i += 2) {
+        __m128 x = _mm_loadu_ps(a + i * 2);
+        __m128 y = _mm_loadu_ps(b + i * 2);
+        direct = _mm_add_ps(direct, _mm_mul_ps(x, y));
+        crossed = _mm_add_ps(crossed, _mm_mul_ps(x, _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+    const __m128 alternate = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+    sumRe = horizontalSum(_mm_mul_ps(direct, alternate));
+    sumIm = horizontalSum(crossed);
+#endif
+
+    for (; i < count; ++i) {
+        float ar = a[i * 2];
+        float ai = a[i * 2 + 1];
+        float br = b[i * 2];
+        float bi = b[i * 2 + 1];
+        sumRe += ar * br - ai * bi;
+        sumIm += ar * bi + ai * br;
+    }
+
+    re = sumRe;
+    im = sumIm;
+}
+
+void smooth(float* state, const float* input, size_t count, float keep) {
+    const float take = 1.0f - keep;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 keepVec = _mm256_set1_ps(keep);
+    const __m256 takeVec = _mm256_set1_ps(take);
+    for (; i + 8 <= count; i += 8) {
+        __m256 value = _mm256_add_ps(
+            _mm256_mul_ps(_mm256_loadu_ps(state + i), keepVec),
+            _mm256_mul_ps(_mm256_loadu_ps(input + i), takeVec));
+        _mm256_storeu_ps(state + i, value);
+    }
+#elif defined(__SSE2__)
+    const __m128 keepVec = _mm_set1_ps(keep);
+    const __m128 takeVec = _mm_set1_ps(take);
+    for (; i + 4 <= count; i += 4) {
+        __m128 value = _mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(state + i), keepVec),
+            _mm_mul_ps(_mm_loadu_ps(input + i), takeVec));
+        _mm_storeu_ps(state + i, value);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        state[i] = keep * state[i] + take * input[i];
+    }
+}
+
+SpectrumSums spectrumSums(const float* magnitudes, float* previous, float* chunkPower,
+                          size_t count, size_t chunkSize) {
+    SpectrumSums sums = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+#if defined(__AVX2__)
+    __m256 magnitudeAcc = _mm256_setzero_ps();
+    __m256 weightedAcc = _mm256_setzero_ps();
+    __m256 logAcc = _mm256_setzero_ps();
+    __m256 riseAcc = _mm256_setzero_ps();
+    const __m256 floorVec = _mm256_set1_ps(kMagnitudeFloor);
+    const __m256 ramp = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 zero = _mm256_setzero_ps();
+#elif defined(__SSE2__)
+    __m128 magnitudeAcc = _mm_setzero_ps();
+    __m128 weightedAcc = _mm_setzero_ps();
+    __m128 logAcc = _mm_setzero_ps();
+    __m128 riseAcc = _mm_setzero_ps();
+    const __m128 floorVec = _mm_set1_ps(kMagnitudeFloor);
+    const __m128 ramp = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 zero = _mm_setzero_ps();
+#endif
+
+    // Power is summed per chunk so the rolloff can be located afterwards
+    // without another pass over every bin
+    size_t chunk = 0;
+    for (size_t start = 0; start < count; start += chunkSize, ++chunk) {
+        const size_t end = std::min(count, start + chunkSize);
+        size_t i = start;
+        float power = 0.0f;
+
+#if defined(__AVX2__)
+        __m256 powerAcc = _mm256_setzero_ps();
+        __m256 index = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), ramp);
+        for (; i + 8 <= end; i += 8) {
+            __m256 value = _mm256_loadu_ps(magnitudes + i);
+            __m256 last = _mm256_loadu_ps(previous + i);
+            _mm256_storeu_ps(previous + i, value);
+            magnitudeAcc = _mm256_add_ps(magnitudeAcc, value);
+            weightedAcc = _mm256_add_ps(weightedAcc, _mm256_mul_ps(value, index));
+            powerAcc = _mm256_add_ps(powerAcc, _mm256_mul_ps(value, value));
+            logAcc = _mm256_add_ps(logAcc, fastLog2(_mm256_add_ps(value, floorVec)));
+            riseAcc = _mm256_add_ps(riseAcc, _mm256_max_ps(_mm256_sub_ps(value, last), zero));
+            index = _mm256_add_ps(index, _mm256_set1_ps(8.0f));
+        }
+        power = horizontalSum(powerAcc);
+#elif defined(__SSE2__)
+        __m128 powerAcc = _mm_setzero_ps();
+        __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), ramp);
+        for (; i + 4 <= end; i += 4) {
+            __m128 value = _mm_loadu_ps(magnitudes + i);
+            __m128 last = _mm_loadu_ps(previous + i);
+            _mm_storeu_ps(previous + i, value);
+            magnitudeAcc = _mm_add_ps(magnitudeAcc, value);
+            weightedAcc = _mm_add_ps(weightedAcc, _mm_mul_ps(value, index));
+            powerAcc = _mm_add_ps(powerAcc, _mm_mul_ps(value, value));
+            logAcc = _mm_add_ps(logAcc, fastLog2(_mm_add_ps(value, floorVec)));
+            riseAcc = _mm_add_ps(riseAcc, _mm_max_ps(_mm_sub_ps(value, last), zero));
+            index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+        }
+        power = horizontalSum(powerAcc);
+#endif
+
+        for (; i < end; ++i) {
+            float value = magnitudes[i];
+            sums.magnitude += value;
+            sums.weightedIndex += value * static_cast<float>(i);
+            power += value * value;
+            sums.logPower += fastLog2(value + kMagnitudeFloor);
+            sums.rise += std::max(0.0f, value - previous[i]);
+            previous[i] = value;
+        }
+
+        chunkPower[chunk] = power;
+        sums.power += power;
+    }
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    sums.magnitude += horizontalSum(magnitudeAcc);
+    sums.weightedIndex += horizontalSum(weightedAcc);
+    sums.logPower += horizontalSum(logAcc);
+    sums.rise += horizontalSum(riseAcc);
+#endif
+
+    // log2(m^2) = 2 * log2(m)
+    sums.logPower *= 2.0f;
+    return sums;
+}
+
+BlockSums blockSums(const float* interleaved, size_t count, int channels) {
+    BlockSums sums = {0.0f, 0.0f, 0};
+    const size_t stride = static_cast<size_t>(channels);
+    size_t i = 0;
+
+    // The first frame has nothing to cross from
+    for (; i < std::min(stride, count); ++i) {
+        sums.squares += interleaved[i] * interleaved[i];
+        sums.peak = std::max(sums.peak, std::fabs(interleaved[i]));
+    }
+
+#if defined(__SSE2__)
+    // Each sample is compared with the same channel one frame earlier; a
+    // crossing is a differing sign bit
+    __m128 squaresAcc = _mm_setzero_ps();
+    __m128 peakAcc = _mm_setzero_ps();
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (; i + 4 <= count; i += 4) {
+        __m128 value = _mm_loadu_ps(interleaved + i);
+        __m128 last = _mm_loadu_ps(interleaved + i - stride);
+        squaresAcc = _mm_add_ps(squaresAcc, _mm_mul_ps(value, value));
+        peakAcc = _mm_max_ps(peakAcc, _mm_and_ps(value, absMask));
+        sums.crossings += kMaskBitCount[_mm_movemask_ps(_mm_xor_ps(value, last))];
+    }
+    sums.squares += horizontalSum(squaresAcc);
+    peakAcc = _mm_max_ps(peakAcc, _mm_movehl_ps(peakAcc, peakAcc));
+    peakAcc = _mm_max_ss(peakAcc, _mm_shuffle_ps(peakAcc, peakAcc, 1));
+    sums.peak = std::max(sums.peak, _mm_cvtss_f32(peakAcc));
+#endif
+
+    for (; i < count; ++i) {
+        float value = interleaved[i];
+        sums.squares += value * value;
+        sums.peak = std::max(sums.peak, std::fabs(value));
+        if (std::signbit(value) != std::signbit(interleaved[i - stride])) {
+            ++sums.crossings;
+        }
+    }
+
+    return sums;
+}
+
+} // namespace dsp
@@ -0,0 +1,104 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include "analysis/feature_extractor.h"
+#include "analysis/dsp_kernels.h"
+
+// Fraction of the power below the rolloff frequency
+static const float kRolloffFraction = 0.85f;
+
+// Bins per rolloff chunk, a multiple of the vector width
+static const size_t kChunkSize = 64;
+
+// Totals below this are treated as silence
+static const float kSilence = 1e-9f;
+
+FeatureExtractor::FeatureExtractor()
+    : m_binWidth(0.0f)
+    , m_numBins(0)
+{
+}
+
+FeatureExtractor::~FeatureExtractor() {
+}
+
+bool FeatureExtractor::initialize(int sampleRate, int fftSize) {
+    if (sampleRate <= 0 || fftSize < 2) {
+        std::cerr << "Invalid feature extractor sample rate " << sampleRate
+                  << " or FFT size " << fftSize << std::endl;
+        return false;
+    }
+
+    m_binWidth = static_cast<float>(sampleRate) / fftSize;
+    m_numBins = fftSize / 2 + 1;
+    m_previousMagnitudes.assign(m_numBins, 0.0f);
+    m_chunkPower.assign((m_numBins + kChunkSize - 1) / kChunkSize, 0.0f);
+    m_features = SpectralFeatures();
+
+    return true;
+}
+
+void FeatureExtractor::processSpectrum(const float* magnitudes) {
+    if (!magnitudes || m_numBins == 0) {
+        return;
+    }
+
+    dsp::SpectrumSums sums = dsp::spectrumSums(
+        magnitudes, m_previousMagnitudes.data(), m_chunkPower.data(), m_numBins, kChunkSize);
+
+    if (sums.magnitude < kSilence || sums.power < kSilence) {
+        m_features.centroid = 0.0f;
+        m_features.rolloff = 0.0f;
+        m_features.flatness = 0.0f;
+        m_features.flux = 0.0f;
+        return;
+    }
+
+    m_features.centroid = sums.weightedIndex / sums.magnitude * m_binWidth;
+    m_features.flatness = std::min(1.0f, std::exp2(sums.logPower / m_numBins) / (sums.power / m_numBins));
+    m_features.flux = std::min(1.0f, sums.rise / sums.magnitude);
+
+    // Find the chunk where the running power crosses the target, then the
+    // bin within it; only that chunk is read again
+    float target = kRolloffFraction * sums.power;
+    float runningPower = 0.0f;
+    size_t chunk = 0;
+    while (chunk + 1 < m_chunkPower.size() && runningPower + m_chunkPower[chunk] < target) {
+        runningPower += m_chunkPower[chunk];
+        ++chunk;
+    }
+
+    size_t bin = chunk * kChunkSize;
+    const size_t end = std::min(static_cast<size_t>(m_numBins), bin + kChunkSize);
+    for (; bin + 1 < end; ++bin) {
+        runningPower += magnitudes[bin] * magnitudes[bin];
+        if (runningPower >= target) {
+            break;
+        }
+    }
+    m_features.rolloff = bin * m_binWidth;
+}
+
+void FeatureExtractor::processSamples(const float* samples, size_t frameCount, int channels) {
+    if (!samples || frameCount == 0 || channels < 1) {
+        return;
+    }
+
+    const size_t count = frameCount * channels;
+    dsp::BlockSums sums = dsp::blockSums(samples, count, channels);
+
+    m_features.rms = std::sqrt(sums.squares / count);
+    m_features.crestFactor = m_features.rms > kSilence ? sums.peak / m_features.rms : 0.0f;
+    m_features.zeroCrossingRate = frameCount > 1
+        ? static_cast<float>(sums.crossings) / ((frameCount - 1) * channels)
+        : 0.0f;
+}
+
+void FeatureExtractor::reset() {
+    std::fill(m_previousMagnitudes.begin(), m_previousMagnitudes.end(), 0.0f);
+    m_features = SpectralFeatures();
+}
+
+const SpectralFeatures& FeatureExtractor::getFeatures() const {
+    return m_features;
+}
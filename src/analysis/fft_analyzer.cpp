@@ -2,162 +2,431 @@
 #include <iostream>
 #include <algorithm>
 #include "analysis/fft_analyzer.h"
+#include "analysis/dsp_kernels.h"
+#include "analysis/fft_planner.h"
+#include "analysis/polyphase_decimator.h"
+#include "analysis/filterbank.h"
+
+// Lowest frequency of the multi-resolution spectrum in Hz
+static const float kMinFrequency = 20.0f;
+
+// Crossover as a fraction of the decimated Nyquist frequency, below the
+// decimator's transition band
+static const float kCrossoverFraction = 0.7f;
+
+// The long window moves this fraction of its length per update, plenty for
+// the time resolution it has
+static const int kLowHopDivisor = 8;
 
 FFTAnalyzer::FFTAnalyzer()
     : m_windowSize(0)
+    , m_hopSize(0)
+    , m_historyIndex(0)
+    , m_samplesSinceHop(0)
+    , m_frameCount(0)
     , m_numBins(0)
-    , m_fftInput(nullptr)
-    , m_fftOutput(nullptr)
+    , m_batchSize(0)
+    , m_pendingHops(0)
+    , m_newestRow(-1)
+    , m_inputStride(0)
+    , m_outputStride(0)
+    , m_batchInput(nullptr)
+    , m_batchOutput(nullptr)
     , m_fftPlan(nullptr)
+    , m_batchPlan(nullptr)
+    , m_lowBandCount(0)
+    , m_crossoverFrequency(0.0f)
 {
 }
 
 FFTAnalyzer::~FFTAnalyzer() {
-    if (m_fftPlan) {
-        fftw_destroy_plan(m_fftPlan);
-        m_fftPlan = nullptr;
-    }
-    
-    if (m_fftInput) {
-        fftw_free(m_fftInput);
-        m_fftInput = nullptr;
-    }
-    
-    if (m_fftOutput) {
-        fftw_free(m_fftOutput);
-        m_fftOutput = nullptr;
-    }
+    releaseFFT();
 }
 
-bool FFTAnalyzer::initialize(int windowSize) {
-    // Clean up if already initialized
-    if (m_fftPlan) {
-        fftw_destroy_plan(m_fftPlan);
-        m_fftPlan = nullptr;
-    }
-    
-    if (m_fftInput) {
-        fftw_free(m_fftInput);
-        m_fftInput = nullptr;
+bool FFTAnalyzer::initialize(int windowSize, int hopSize, int batchSize, WindowFunction window) {
+    if (windowSize <= 0 || hopSize <= 0 || hopSize > windowSize || batchSize <= 0) {
+        std::cerr << "Invalid FFT window size " << windowSize << ", hop size " << hopSize
+                  << " or batch size " << batchSize << std::endl;
+        return false;
     }
     
-    if (m_fftOutput) {
-        fftw_free(m_fftOutput);
-        m_fftOutput = nullptr;
-    }
+    // Clean up if already initialized
+    releaseFFT();
     
-    // Set window size and number of bins
+    // Set window size, hop size and number of bins
     m_windowSize = windowSize;
+    m_hopSize = hopSize;
     m_numBins = windowSize / 2 + 1;
+    m_batchSize = batchSize;
+    m_pendingHops = 0;
+    m_newestRow = -1;
+    
+    // Pad rows to 64 bytes so every row has the alignment the plans were made
+    // for, which lets the single plan run on any row of the batch
+    m_inputStride = (m_windowSize + 15) & ~15;
+    m_outputStride = (m_numBins + 7) & ~7;
     
-    // Allocate memory for FFT input and output
-    m_fftInput = static_cast<double*>(fftw_malloc(sizeof(double) * m_windowSize));
-    m_fftOutput = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * m_numBins));
+    // Allocate memory for the batched FFT input and output
+    m_batchInput = static_cast<float*>(
+        fftwf_malloc(sizeof(float) * m_inputStride * m_batchSize));
+    m_batchOutput = static_cast<fftwf_complex*>(
+        fftwf_malloc(sizeof(fftwf_complex) * m_outputStride * m_batchSize));
     
-    if (!m_fftInput || !m_fftOutput) {
+    if (!m_batchInput || !m_batchOutput) {
         std::cerr << "Failed to allocate memory for FFT" << std::endl;
         return false;
     }
     
-    // Create FFTW plan
-    m_fftPlan = fftw_plan_dft_r2c_1d(m_windowSize, m_fftInput, m_fftOutput, FFTW_MEASURE);
+    // Create FFTW plans, instant when wisdom from an earlier run is cached
+    m_fftPlan = FFTPlanner::createPlan(
+        "r2c " + std::to_string(m_windowSize),
+        [this](unsigned flags) {
+            return fftwf_plan_dft_r2c_1d(m_windowSize, m_batchInput, m_batchOutput, flags);
+        }
+    );
     
     if (!m_fftPlan) {
         std::cerr << "Failed to create FFTW plan" << std::endl;
         return false;
     }
     
-    // Create Hann window function
+    if (m_batchSize > 1) {
+        m_batchPlan = FFTPlanner::createPlan(
+            "r2c " + std::to_string(m_windowSize) + " x" + std::to_string(m_batchSize),
+            [this](unsigned flags) {
+                int length = m_windowSize;
+                return fftwf_plan_many_dft_r2c(
+                    1, &length, m_batchSize,
+                    m_batchInput, nullptr, 1, m_inputStride,
+                    m_batchOutput, nullptr, 1, m_outputStride,
+                    flags);
+            }
+        );
+        
+        if (!m_batchPlan) {
+            std::cerr << "Failed to create batched FFTW plan" << std::endl;
+            return false;
+        }
+    }
+    
+    // Create the window function
     m_window.resize(m_windowSize);
     for (int i = 0; i < m_windowSize; ++i) {
-        m_window[i] = 0.5 * (1.0 - cos(2.0 * M_PI * i / (m_windowSize - 1)));
+        m_window[i] = window == WindowFunction::Rectangular
+            ? 1.0f
+            : static_cast<float>(0.5 * (1.0 - cos(2.0 * M_PI * i / (m_windowSize - 1))));
     }
     
-    // Initialize magnitude vector
-    m_magnitudes.resize(m_numBins, 0.0f);
+    // Initialize magnitude vectors
+    m_magnitudes.assign(m_numBins, 0.0f);
+    m_linearMagnitudes.assign(m_numBins, 0.0f);
+    
+    // Start with a silent history so the first hops are zero padded
+    m_history.assign(m_windowSize, 0.0f);
+    m_historyIndex = 0;
+    m_samplesSinceHop = 0;
+    m_frameSpectra.clear();
+    m_frameLinearSpectra.clear();
+    m_frameCount = 0;
+    
+    // A multi-resolution bank has to be enabled again for the new layout
+    m_decimator.reset();
+    m_lowAnalyzer.reset();
+    m_highAnalyzer.reset();
+    m_lowBands.reset();
+    m_highBands.reset();
+    m_multiResolutionSpectrum.clear();
     
     std::cout << "FFT Analyzer initialized with window size: " << m_windowSize 
-              << ", bins: " << m_numBins << std::endl;
+              << ", hop size: " << m_hopSize << ", bins: " << m_numBins
+              << ", batch: " << m_batchSize << std::endl;
     
     return true;
 }
 
-void FFTAnalyzer::processAudioData(const std::vector<float>& audioData) {
-    if (!m_fftPlan || audioData.empty()) {
-        return;
+int FFTAnalyzer::processAudioData(const std::vector<float>& audioData, int channels) {
+    if (channels < 1) {
+        return 0;
+    }
+    
+    return processAudioData(audioData.data(), audioData.size() / channels, channels);
+}
+
+int FFTAnalyzer::processAudioData(const float* audioData, size_t frameCount, int channels) {
+    m_frameCount = 0;
+    
+    if (!m_fftPlan || !audioData || frameCount == 0 || channels < 1) {
+        return 0;
     }
     
-    // Copy audio data to FFT input buffer
-    // For stereo audio, we'll average the channels
-    int channels = audioData.size() / (m_windowSize / 2);
-    if (channels < 1) channels = 1;
+    // Reserve one spectrum row per hop this call can complete
+    size_t maxHops = (m_samplesSinceHop + frameCount) / m_hopSize;
+    if (m_frameSpectra.size() < maxHops * m_numBins) {
+        m_frameSpectra.resize(maxHops * m_numBins);
+        m_frameLinearSpectra.resize(maxHops * m_numBins);
+    }
     
-    for (int i = 0; i < m_windowSize; ++i) {
-        if (i < audioData.size() / channels) {
-            double sum = 0.0;
-            for (int c = 0; c < channels; ++c) {
-                int index = i * channels + c;
-                if (index < audioData.size()) {
-                    sum += audioData[index];
-                }
-            }
-            m_fftInput[i] = sum / channels;
-        } else {
-            m_fftInput[i] = 0.0;
-        }
+    // Downmix the whole block to mono in one pass
+    if (m_monoBuffer.size() < frameCount) {
+        m_monoBuffer.resize(frameCount);
     }
+    dsp::downmix(audioData, m_monoBuffer.data(), frameCount, channels);
     
-    // Apply window function
-    applyWindow();
+    if (m_decimator) {
+        processMultiResolution(m_monoBuffer.data(), frameCount);
+    }
     
-    // Execute FFT
-    fftw_execute(m_fftPlan);
+    // Copy into the history ring up to each hop boundary, so every hop is
+    // analysed exactly once regardless of how samples arrive
+    size_t offset = 0;
+    while (offset < frameCount) {
+        size_t count = std::min(frameCount - offset, static_cast<size_t>(m_hopSize - m_samplesSinceHop));
+        
+        size_t firstPart = std::min(count, static_cast<size_t>(m_windowSize - m_historyIndex));
+        std::copy_n(m_monoBuffer.data() + offset, firstPart, m_history.data() + m_historyIndex);
+        std::copy_n(m_monoBuffer.data() + offset + firstPart, count - firstPart, m_history.data());
+        
+        m_historyIndex = static_cast<int>((m_historyIndex + count) % m_windowSize);
+        m_samplesSinceHop += static_cast<int>(count);
+        offset += count;
+        
+        if (m_samplesSinceHop == m_hopSize) {
+            m_samplesSinceHop = 0;
+            queueHop();
+        }
+    }
+    
+    // Transform whatever is left of the last batch
+    flushHops();
     
-    // Compute magnitude spectrum
-    computeMagnitudes();
+    return m_frameCount;
 }
 
-void FFTAnalyzer::applyWindow() {
-    for (int i = 0; i < m_windowSize; ++i) {
-        m_fftInput[i] *= m_window[i];
+void FFTAnalyzer::queueHop() {
+    // Unroll the history ring, oldest sample first, applying the window on the way
+    applyWindow(m_batchInput + static_cast<size_t>(m_pendingHops) * m_inputStride);
+    ++m_pendingHops;
+    
+    // The history ring moves on, so a full batch has to be transformed now
+    if (m_pendingHops == m_batchSize) {
+        flushHops();
     }
 }
 
-void FFTAnalyzer::computeMagnitudes() {
-    const double normalizationFactor = 2.0 / m_windowSize;
+void FFTAnalyzer::flushHops() {
+    if (m_pendingHops == 0) {
+        return;
+    }
     
-    // DC component (bin 0)
-    double real = m_fftOutput[0][0];
-    double imag = m_fftOutput[0][1];
-    m_magnitudes[0] = normalizationFactor * sqrt(real * real + imag * imag);
+    // One call for a full batch, otherwise run the single plan row by row
+    if (m_pendingHops == m_batchSize && m_batchPlan) {
+        fftwf_execute(m_batchPlan);
+    } else {
+        for (int row = 0; row < m_pendingHops; ++row) {
+            fftwf_execute_dft_r2c(m_fftPlan,
+                m_batchInput + static_cast<size_t>(row) * m_inputStride,
+                m_batchOutput + static_cast<size_t>(row) * m_outputStride);
+        }
+    }
     
-    // Other bins
-    for (int i = 1; i < m_numBins; ++i) {
-        real = m_fftOutput[i][0];
-        imag = m_fftOutput[i][1];
-        
-        // Compute magnitude
-        double magnitude = normalizationFactor * sqrt(real * real + imag * imag);
-        
-        // Apply logarithmic scaling for better visualization
-        magnitude = 20.0 * log10(magnitude + 1e-6);
-        
-        // Normalize to 0-1 range (assuming signals are between -96dB and 0dB)
-        magnitude = std::max(0.0, magnitude + 96.0) / 96.0;
+    for (int row = 0; row < m_pendingHops; ++row) {
+        // Compute magnitude spectrum into this hop's row
+        size_t offset = static_cast<size_t>(m_frameCount) * m_numBins;
+        float* spectrum = m_frameSpectra.data() + offset;
+        computeMagnitudes(m_batchOutput + static_cast<size_t>(row) * m_outputStride,
+                          m_frameLinearSpectra.data() + offset, spectrum);
         
         // Apply some smoothing with previous value (simple low-pass filter)
-        m_magnitudes[i] = 0.2f * m_magnitudes[i] + 0.8f * magnitude;
+        dsp::smooth(m_magnitudes.data(), spectrum, m_numBins, 0.2f);
+        
+        ++m_frameCount;
+    }
+    
+    // Linear magnitudes of the newest hop stay available after later calls
+    const float* newest = m_frameLinearSpectra.data() + static_cast<size_t>(m_frameCount - 1) * m_numBins;
+    std::copy_n(newest, m_numBins, m_linearMagnitudes.data());
+    
+    m_newestRow = m_pendingHops - 1;
+    m_pendingHops = 0;
+}
+
+void FFTAnalyzer::applyWindow(float* dest) {
+    int tail = m_windowSize - m_historyIndex;
+    dsp::multiply(m_history.data() + m_historyIndex, m_window.data(), dest, tail);
+    dsp::multiply(m_history.data(), m_window.data() + tail, dest + tail, m_historyIndex);
+}
+
+void FFTAnalyzer::computeMagnitudes(const fftwf_complex* fftOutput, float* linear, float* spectrum) {
+    const float normalizationFactor = 2.0f / m_windowSize;
+    
+    // Linear magnitudes for every bin, for the feature extractor and the
+    // harmonic/percussive separation
+    dsp::magnitude(reinterpret_cast<const float*>(fftOutput), linear, m_numBins, normalizationFactor);
+    
+    // Logarithmic scaling for better visualization, normalized to 0-1 over
+    // -96dB..0dB; the DC bin (bin 0) stays linear
+    spectrum[0] = linear[0];
+    dsp::normalizedDecibels(linear + 1, spectrum + 1, m_numBins - 1, 96.0f);
+}
+
+void FFTAnalyzer::processMultiResolution(const float* mono, size_t frameCount) {
+    // Bass: decimate, then run the long window at the reduced rate
+    size_t maxDecimated = frameCount / m_decimator->getFactor() + 1;
+    if (m_decimatedBuffer.size() < maxDecimated) {
+        m_decimatedBuffer.resize(maxDecimated);
+    }
+    size_t decimated = m_decimator->process(mono, frameCount, m_decimatedBuffer.data());
+    int lowHops = m_lowAnalyzer->processAudioData(m_decimatedBuffer.data(), decimated, 1);
+    
+    // Highs: short window at full rate
+    int highHops = m_highAnalyzer->processAudioData(mono, frameCount, 1);
+    
+    // Each side of the merged spectrum changes when its analyzer completes a hop
+    if (lowHops > 0) {
+        m_lowBands->apply(m_lowAnalyzer->getSpectrumData().data(), m_multiResolutionSpectrum.data());
+    }
+    if (highHops > 0) {
+        m_highBands->apply(m_highAnalyzer->getSpectrumData().data(),
+                           m_multiResolutionSpectrum.data() + m_lowBandCount);
+    }
+}
+
+bool FFTAnalyzer::enableMultiResolution(int sampleRate, int decimation, int lowWindowSize,
+                                        int highWindowSize, int bandCount) {
+    if (m_hopSize <= 0) {
+        std::cerr << "FFT analyzer must be initialized before the multi-resolution bank" << std::endl;
+        return false;
+    }
+    
+    if (sampleRate <= 0 || decimation < 2 || bandCount < 2) {
+        std::cerr << "Invalid multi-resolution sample rate " << sampleRate << ", decimation "
+                  << decimation << " or band count " << bandCount << std::endl;
+        return false;
+    }
+    
+    const float nyquist = sampleRate * 0.5f;
+    const float crossover = kCrossoverFraction * nyquist / decimation;
+    if (crossover <= kMinFrequency * 2.0f) {
+        std::cerr << "Decimation " << decimation << " leaves no bass range at "
+                  << sampleRate << " Hz" << std::endl;
+        return false;
     }
+    
+    // Split the bands in proportion to the octaves on each side, so the merged
+    // bands stay evenly spaced on the log scale
+    float lowOctaves = std::log2(crossover / kMinFrequency);
+    float totalOctaves = std::log2(nyquist / kMinFrequency);
+    int lowBandCount = std::clamp(static_cast<int>(std::lround(bandCount * lowOctaves / totalOctaves)),
+                                  1, bandCount - 1);
+    
+    auto decimator = std::make_unique<PolyphaseDecimator>();
+    auto lowAnalyzer = std::make_unique<FFTAnalyzer>();
+    auto highAnalyzer = std::make_unique<FFTAnalyzer>();
+    auto lowBands = std::make_unique<Filterbank>();
+    auto highBands = std::make_unique<Filterbank>();
+    
+    if (!decimator->initialize(decimation)
+        || !lowAnalyzer->initialize(lowWindowSize, std::max(1, lowWindowSize / kLowHopDivisor))
+        || !highAnalyzer->initialize(highWindowSize, m_hopSize)
+        || !lowBands->initialize(sampleRate / decimation, lowWindowSize, lowBandCount,
+                                 FilterbankScale::Log, kMinFrequency, crossover)
+        || !highBands->initialize(sampleRate, highWindowSize, bandCount - lowBandCount,
+                                  FilterbankScale::Log, crossover)) {
+        std::cerr << "Failed to initialize multi-resolution bank" << std::endl;
+        return false;
+    }
+    
+    m_decimator = std::move(decimator);
+    m_lowAnalyzer = std::move(lowAnalyzer);
+    m_highAnalyzer = std::move(highAnalyzer);
+    m_lowBands = std::move(lowBands);
+    m_highBands = std::move(highBands);
+    m_lowBandCount = lowBandCount;
+    m_crossoverFrequency = crossover;
+    m_multiResolutionSpectrum.assign(bandCount, 0.0f);
+    
+    std::cout << "Multi-resolution bank: " << lowBandCount << " bands below " << crossover
+              << " Hz from a " << lowWindowSize << " window at 1/" << decimation << " rate, "
+              << bandCount - lowBandCount << " above from a " << highWindowSize << " window" << std::endl;
+    
+    return true;
+}
+
+bool FFTAnalyzer::isMultiResolutionEnabled() const {
+    return m_decimator != nullptr;
+}
+
+const std::vector<float>& FFTAnalyzer::getMultiResolutionSpectrum() const {
+    return m_multiResolutionSpectrum;
+}
+
+float FFTAnalyzer::getCrossoverFrequency() const {
+    return m_crossoverFrequency;
 }
 
 const std::vector<float>& FFTAnalyzer::getSpectrumData() const {
     return m_magnitudes;
 }
 
+const fftwf_complex* FFTAnalyzer::getComplexSpectrum() const {
+    if (m_newestRow < 0) {
+        return nullptr;
+    }
+    return m_batchOutput + static_cast<size_t>(m_newestRow) * m_outputStride;
+}
+
+const std::vector<float>& FFTAnalyzer::getLinearSpectrum() const {
+    return m_linearMagnitudes;
+}
+
+int FFTAnalyzer::getFrameCount() const {
+    return m_frameCount;
+}
+
+const float* FFTAnalyzer::getFrameSpectrum(int frame) const {
+    if (frame < 0 || frame >= m_frameCount) {
+        return nullptr;
+    }
+    return m_frameSpectra.data() + static_cast<size_t>(frame) * m_numBins;
+}
+
+const float* FFTAnalyzer::getFrameLinearSpectrum(int frame) const {
+    if (frame < 0 || frame >= m_frameCount) {
+        return nullptr;
+    }
+    return m_frameLinearSpectra.data() + static_cast<size_t>(frame) * m_numBins;
+}
+
 int FFTAnalyzer::getWindowSize() const {
     return m_windowSize;
 }
 
+int FFTAnalyzer::getHopSize() const {
+    return m_hopSize;
+}
+
 int FFTAnalyzer::getNumBins() const {
     return m_numBins;
+}
+
+void FFTAnalyzer::releaseFFT() {
+    if (m_batchPlan) {
+        fftwf_destroy_plan(m_batchPlan);
+        m_batchPlan = nullptr;
+    }
+    
+    if (m_fftPlan) {
+        fftwf_destroy_plan(m_fftPlan);
+        m_fftPlan = nullptr;
+    }
+    
+    if (m_batchInput) {
+        fftwf_free(m_batchInput);
+        m_batchInput = nullptr;
+    }
+    
+    if (m_batchOutput) {
+        fftwf_free(m_batchOutput);
+        m_batchOutput = nullptr;
+    }
 }
\ No newline at end of file
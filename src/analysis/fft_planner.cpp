@@ -0,0 +1,89 @@
+#include <iostream>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <unistd.h>
+#include "analysis/fft_planner.h"
+#include "util/cache_directory.h"
+
+static std::mutex s_plannerMutex;
+static bool s_wisdomLoaded = false;
+static double s_totalPlanningTime = 0.0;
+
+fftwf_plan FFTPlanner::createPlan(
+    const std::string& description,
+    const std::function<fftwf_plan(unsigned flags)>& makePlan
+) {
+    std::lock_guard<std::mutex> lock(s_plannerMutex);
+    
+    loadWisdom();
+    
+    auto startTime = std::chrono::steady_clock::now();
+    
+    // Repeat launches find the plan in the imported wisdom
+    fftwf_plan plan = makePlan(FFTW_PATIENT | FFTW_WISDOM_ONLY);
+    bool fromWisdom = plan != nullptr;
+    
+    // First run pays for a patient search once, then saves it
+    if (!plan) {
+        plan = makePlan(FFTW_PATIENT);
+        if (plan) {
+            saveWisdom();
+        }
+    }
+    
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    s_totalPlanningTime += elapsed;
+    
+    if (plan) {
+        std::cout << "FFTW plan for " << description << " "
+                  << (fromWisdom ? "loaded from wisdom" : "measured") << " in "
+                  << elapsed * 1000.0 << " ms" << std::endl;
+    } else {
+        std::cerr << "Failed to create FFTW plan for " << description << std::endl;
+    }
+    
+    return plan;
+}
+
+double FFTPlanner::getTotalPlanningTime() {
+    std::lock_guard<std::mutex> lock(s_plannerMutex);
+    return s_totalPlanningTime;
+}
+
+void FFTPlanner::loadWisdom() {
+    if (s_wisdomLoaded) {
+        return;
+    }
+    s_wisdomLoaded = true;
+    
+    std::string path = getWisdomPath();
+    if (!path.empty() && fftwf_import_wisdom_from_filename(path.c_str())) {
+        std::cout << "Loaded FFTW wisdom from: " << path << std::endl;
+    }
+}
+
+void FFTPlanner::saveWisdom() {
+    std::string path = getWisdomPath();
+    if (path.empty()) {
+        return;
+    }
+    
+    // Write to a temporary file and rename it so another instance never
+    // imports half-written wisdom
+    std::string tempPath = path + ".tmp." + std::to_string(getpid());
+    if (!fftwf_export_wisdom_to_filename(tempPath.c_str())
+        || rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to save FFTW wisdom to: " << path << std::endl;
+        remove(tempPath.c_str());
+    }
+}
+
+std::string FFTPlanner::getWisdomPath() {
+    std::string directory = getCacheDirectory();
+    if (directory.empty()) {
+        return "";
+    }
+    return (std::filesystem::path(directory) / "fftwf_wisdom").string();
+}
@@ -0,0 +1,182 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include "analysis/filterbank.h"
+#include "analysis/dsp_kernels.h"
+
+// Map a frequency onto the scale the band edges are evenly spaced on
+static float toScale(float frequency, FilterbankScale scale) {
+    if (scale == FilterbankScale::Mel) {
+        return 2595.0f * std::log10(1.0f + frequency / 700.0f);
+    }
+    return std::log2(frequency);
+}
+
+// Inverse of toScale
+static float fromScale(float value, FilterbankScale scale) {
+    if (scale == FilterbankScale::Mel) {
+        return 700.0f * (std::pow(10.0f, value / 2595.0f) - 1.0f);
+    }
+    return std::exp2(value);
+}
+
+Filterbank::Filterbank()
+    : m_sampleRate(0)
+    , m_fftSize(0)
+    , m_bandCount(0)
+    , m_scale(FilterbankScale::Log)
+    , m_minFrequency(0.0f)
+    , m_maxFrequency(0.0f)
+    , m_numBins(0)
+{
+}
+
+Filterbank::~Filterbank() {
+}
+
+bool Filterbank::initialize(int sampleRate, int fftSize, int bandCount, FilterbankScale scale,
+                            float minFrequency, float maxFrequency) {
+    const float nyquist = sampleRate * 0.5f;
+    if (maxFrequency <= 0.0f || maxFrequency > nyquist) {
+        maxFrequency = nyquist;
+    }
+    
+    if (sampleRate <= 0 || fftSize < 4 || bandCount <= 0
+        || minFrequency <= 0.0f || minFrequency >= maxFrequency) {
+        std::cerr << "Invalid filterbank layout: " << sampleRate << " Hz, FFT size " << fftSize
+                  << ", " << bandCount << " bands from " << minFrequency << " to "
+                  << maxFrequency << " Hz" << std::endl;
+        return false;
+    }
+
+    // The matrix only depends on the layout, so keep it if nothing changed
+    if (sampleRate == m_sampleRate && fftSize == m_fftSize
+        && bandCount == m_bandCount && scale == m_scale
+        && minFrequency == m_minFrequency && maxFrequency == m_maxFrequency) {
+        return true;
+    }
+
+    m_sampleRate = sampleRate;
+    m_fftSize = fftSize;
+    m_bandCount = bandCount;
+    m_scale = scale;
+    m_minFrequency = minFrequency;
+    m_maxFrequency = maxFrequency;
+    m_numBins = fftSize / 2 + 1;
+
+    m_bandFirstBin.clear();
+    m_bandLength.clear();
+    m_bandOffset.clear();
+    m_weights.clear();
+    m_bandFrequencies.clear();
+
+    const float binWidth = static_cast<float>(sampleRate) / fftSize;
+    const float minScale = toScale(minFrequency, scale);
+    const float maxScale = toScale(maxFrequency, scale);
+
+    // Triangular bands overlap their neighbours, so they need two extra edges
+    const bool triangular = scale != FilterbankScale::Octave;
+    const int edgeCount = triangular ? bandCount + 2 : bandCount + 1;
+
+    std::vector<float> edges(edgeCount);
+    for (int i = 0; i < edgeCount; ++i) {
+        float t = static_cast<float>(i) / (edgeCount - 1);
+        edges[i] = fromScale(minScale + t * (maxScale - minScale), scale);
+    }
+
+    std::vector<float> weights;
+    for (int band = 0; band < bandCount; ++band) {
+        float lower = edges[band];
+        float upper = triangular ? edges[band + 2] : edges[band + 1];
+        float center = triangular ? edges[band + 1] : std::sqrt(lower * upper);
+
+        // Bins strictly inside the band, the DC bin is never used
+        int firstBin = std::max(1, static_cast<int>(std::floor(lower / binWidth)) + 1);
+        int lastBin = std::min(m_numBins - 1, static_cast<int>(std::ceil(upper / binWidth)) - 1);
+
+        weights.clear();
+        for (int bin = firstBin; bin <= lastBin; ++bin) {
+            float frequency = bin * binWidth;
+            float weight = 1.0f;
+            if (triangular) {
+                weight = frequency <= center
+                    ? (frequency - lower) / (center - lower)
+                    : (upper - frequency) / (upper - center);
+            }
+            weights.push_back(std::max(0.0f, weight));
+        }
+
+        float total = 0.0f;
+        for (float weight : weights) {
+            total += weight;
+        }
+
+        // Low bands narrower than one bin interpolate between the two bins
+        // around their centre instead of repeating a single bin
+        if (total <= 0.0f) {
+            float position = std::min(center / binWidth, static_cast<float>(m_numBins - 1));
+            firstBin = std::clamp(static_cast<int>(position), 1, m_numBins - 2);
+            float fraction = std::clamp(position - firstBin, 0.0f, 1.0f);
+            weights.assign({1.0f - fraction, fraction});
+        }
+
+        addBand(firstBin, weights, center);
+    }
+
+    m_bandData.assign(bandCount, 0.0f);
+
+    std::cout << "Filterbank initialized with " << bandCount << " bands, "
+              << m_weights.size() << " weights over " << m_numBins << " bins" << std::endl;
+
+    return true;
+}
+
+void Filterbank::process(const std::vector<float>& spectrum) {
+    if (static_cast<int>(spectrum.size()) < m_numBins || m_bandData.empty()) {
+        return;
+    }
+
+    apply(spectrum.data(), m_bandData.data());
+}
+
+void Filterbank::apply(const float* spectrum, float* bands) const {
+    for (int band = 0; band < m_bandCount; ++band) {
+        bands[band] = dsp::dotProduct(
+            spectrum + m_bandFirstBin[band],
+            m_weights.data() + m_bandOffset[band],
+            m_bandLength[band]
+        );
+    }
+}
+
+const std::vector<float>& Filterbank::getBandData() const {
+    return m_bandData;
+}
+
+int Filterbank::getBandCount() const {
+    return m_bandCount;
+}
+
+float Filterbank::getBandFrequency(int band) const {
+    if (band < 0 || band >= m_bandCount) {
+        return 0.0f;
+    }
+    return m_bandFrequencies[band];
+}
+
+void Filterbank::addBand(int firstBin, const std::vector<float>& weights, float centerFrequency) {
+    float total = 0.0f;
+    for (float weight : weights) {
+        total += weight;
+    }
+
+    m_bandFirstBin.push_back(firstBin);
+    m_bandLength.push_back(static_cast<int>(weights.size()));
+    m_bandOffset.push_back(static_cast<int>(m_weights.size()));
+    m_bandFrequencies.push_back(centerFrequency);
+
+    // Normalize so a band stays in the same 0-1 range as the spectrum
+    for (float weight : weights) {
+        m_weights.push_back(weight / total);
+    }
+}
@@ -0,0 +1,182 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include "analysis/multichannel_analyzer.h"
+#include "analysis/fft_analyzer.h"
+#include "analysis/dsp_kernels.h"
+#include "util/thread_pool.h"
+
+// Largest supported channel count
+static const int kMaxChannels = 8;
+
+// Range the mid and side levels are normalized over, same as the FFT spectrum
+static const float kRangeDb = 96.0f;
+
+MultichannelAnalyzer::MultichannelAnalyzer()
+    : m_windowSize(0)
+{
+}
+
+MultichannelAnalyzer::~MultichannelAnalyzer() {
+}
+
+bool MultichannelAnalyzer::initialize(const ChannelLayout& layout, int sampleRate, int windowSize, int hopSize,
+                                      int bandCount, std::shared_ptr<ThreadPool> pool) {
+    if (layout.channels < 1 || layout.channels > kMaxChannels) {
+        std::cerr << "Unsupported channel count for multichannel analysis: " << layout.channels
+                  << " (1 to " << kMaxChannels << ")" << std::endl;
+        return false;
+    }
+
+    std::vector<std::unique_ptr<FFTAnalyzer>> analyzers;
+    for (int c = 0; c < layout.channels; ++c) {
+        auto analyzer = std::make_unique<FFTAnalyzer>();
+        if (!analyzer->initialize(windowSize, hopSize)) {
+            return false;
+        }
+        analyzers.push_back(std::move(analyzer));
+    }
+
+    if (layout.hasStereoPair() && !m_filterbank.initialize(sampleRate, windowSize, bandCount)) {
+        return false;
+    }
+
+    m_layout = layout;
+    m_windowSize = windowSize;
+    m_analyzers = std::move(analyzers);
+    m_hops.assign(layout.channels, 0);
+    m_channelPointers.assign(layout.channels, nullptr);
+    m_pool = pool;
+
+    const int numBins = windowSize / 2 + 1;
+    const int pairBins = layout.hasStereoPair() ? numBins : 0;
+    const int pairBands = layout.hasStereoPair() ? bandCount : 0;
+    m_binMid.assign(pairBins, 0.0f);
+    m_binSide.assign(pairBins, 0.0f);
+    m_binLeft.assign(pairBins, 0.0f);
+    m_binRight.assign(pairBins, 0.0f);
+    m_binCross.assign(pairBins, 0.0f);
+    m_bandLeft.assign(pairBands, 0.0f);
+    m_bandRight.assign(pairBands, 0.0f);
+    m_bandCross.assign(pairBands, 0.0f);
+    m_midBands.assign(pairBands, 0.0f);
+    m_sideBands.assign(pairBands, 0.0f);
+    m_correlation.assign(pairBands, 0.0f);
+
+    std::cout << "Multichannel analyzer initialized for " << layout.channels << " channels ("
+              << layout.describe() << ")";
+    if (layout.hasStereoPair()) {
+        std::cout << ", mid/side from " << layout.names[layout.left] << "/" << layout.names[layout.right];
+    }
+    std::cout << std::endl;
+
+    return true;
+}
+
+int MultichannelAnalyzer::getMaxChannels() {
+    return kMaxChannels;
+}
+
+int MultichannelAnalyzer::processAudioData(const float* audioData, size_t frameCount) {
+    if (m_analyzers.empty() || !audioData || frameCount == 0) {
+        return 0;
+    }
+
+    // One pass splits the block into a row per channel
+    const int channels = m_layout.channels;
+    if (m_planar.size() < frameCount * channels) {
+        m_planar.resize(frameCount * channels);
+    }
+    for (int c = 0; c < channels; ++c) {
+        m_channelPointers[c] = m_planar.data() + static_cast<size_t>(c) * frameCount;
+    }
+    dsp::deinterleave(audioData, m_channelPointers.data(), frameCount, channels);
+
+    // The channels share nothing, so each STFT is one task
+    auto analyzeChannel = [this, frameCount](size_t channel, int) {
+        m_hops[channel] = m_analyzers[channel]->processAudioData(m_channelPointers[channel], frameCount, 1);
+    };
+    if (m_pool) {
+        m_pool->parallelFor(channels, analyzeChannel);
+    } else {
+        for (int c = 0; c < channels; ++c) {
+            analyzeChannel(c, 0);
+        }
+    }
+
+    // Every channel saw the same frames, so they all produced the same hops
+    int hops = m_hops[0];
+    if (hops > 0 && m_layout.hasStereoPair()) {
+        analyzePair();
+    }
+
+    return hops;
+}
+
+void MultichannelAnalyzer::analyzePair() {
+    const fftwf_complex* left = m_analyzers[m_layout.left]->getComplexSpectrum();
+    const fftwf_complex* right = m_analyzers[m_layout.right]->getComplexSpectrum();
+    if (!left || !right) {
+        return;
+    }
+
+    // mid = (L + R) / 2 and side = (L - R) / 2 hold bin by bin
+    const size_t numBins = m_binMid.size();
+    for (size_t bin = 0; bin < numBins; ++bin) {
+        float leftRe = left[bin][0];
+        float leftIm = left[bin][1];
+        float rightRe = right[bin][0];
+        float rightIm = right[bin][1];
+        float sumRe = leftRe + rightRe;
+        float sumIm = leftIm + rightIm;
+        float differenceRe = leftRe - rightRe;
+        float differenceIm = leftIm - rightIm;
+
+        m_binMid[bin] = 0.25f * (sumRe * sumRe + sumIm * sumIm);
+        m_binSide[bin] = 0.25f * (differenceRe * differenceRe + differenceIm * differenceIm);
+        m_binLeft[bin] = leftRe * leftRe + leftIm * leftIm;
+        m_binRight[bin] = rightRe * rightRe + rightIm * rightIm;
+        m_binCross[bin] = leftRe * rightRe + leftIm * rightIm;
+    }
+
+    m_filterbank.apply(m_binMid.data(), m_midBands.data());
+    m_filterbank.apply(m_binSide.data(), m_sideBands.data());
+    m_filterbank.apply(m_binLeft.data(), m_bandLeft.data());
+    m_filterbank.apply(m_binRight.data(), m_bandRight.data());
+    m_filterbank.apply(m_binCross.data(), m_bandCross.data());
+
+    // Band powers to amplitudes on the same 2/N scale as the spectrum
+    const float amplitudeScale = 2.0f / m_windowSize;
+    const size_t bandCount = m_midBands.size();
+    for (size_t band = 0; band < bandCount; ++band) {
+        m_midBands[band] = std::sqrt(m_midBands[band]) * amplitudeScale;
+        m_sideBands[band] = std::sqrt(m_sideBands[band]) * amplitudeScale;
+
+        float power = m_bandLeft[band] * m_bandRight[band];
+        m_correlation[band] = power > 0.0f
+            ? std::max(-1.0f, std::min(1.0f, m_bandCross[band] / std::sqrt(power)))
+            : 0.0f;
+    }
+    dsp::normalizedDecibels(m_midBands.data(), m_midBands.data(), bandCount, kRangeDb);
+    dsp::normalizedDecibels(m_sideBands.data(), m_sideBands.data(), bandCount, kRangeDb);
+}
+
+const ChannelLayout& MultichannelAnalyzer::getLayout() const {
+    return m_layout;
+}
+
+const std::vector<float>& MultichannelAnalyzer::getChannelSpectrum(int channel) const {
+    return m_analyzers[channel]->getSpectrumData();
+}
+
+const std::vector<float>& MultichannelAnalyzer::getMidBands() const {
+    return m_midBands;
+}
+
+const std::vector<float>& MultichannelAnalyzer::getSideBands() const {
+    return m_sideBands;
+}
+
+const std::vector<float>& MultichannelAnalyzer::getCorrelation() const {
+    return m_correlation;
+}
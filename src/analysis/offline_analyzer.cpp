@@ -0,0 +1,161 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "analysis/offline_analyzer.h"
+#include "analysis/fft_analyzer.h"
+#include "analysis/beat_detector.h"
+#include "audio/audio_buffer.h"
+
+// Frames per block handed to the beat detector, matches the live callback
+static const int kBlockFrames = 1024;
+
+// Blocks read per FFT call, large enough to fill several FFT batches
+static const int kBlocksPerChunk = 16;
+
+OfflineAnalyzer::OfflineAnalyzer()
+    : m_windowSize(2048)
+    , m_hopSize(256)
+    , m_beatSensitivity(0.25f)
+{
+}
+
+OfflineAnalyzer::~OfflineAnalyzer() {
+}
+
+bool OfflineAnalyzer::initialize(int windowSize, int hopSize, float beatSensitivity) {
+    if (windowSize <= 0 || hopSize <= 0 || hopSize > windowSize) {
+        std::cerr << "Invalid offline analysis window or hop size" << std::endl;
+        return false;
+    }
+    
+    m_windowSize = windowSize;
+    m_hopSize = hopSize;
+    m_beatSensitivity = beatSensitivity;
+    
+    return true;
+}
+
+bool OfflineAnalyzer::analyzeFile(const std::string& inputPath, const std::string& outputPath) {
+    // Load the whole track. A batch run reads the PCM cache when a track is
+    // already in it but does not add to it, so analysing a library does not
+    // fill the disk or evict the tracks that are actually played.
+    AudioBuffer audioBuffer;
+    if (!audioBuffer.loadFromFile(inputPath, false)) {
+        std::cerr << "Failed to load audio file: " << inputPath << std::endl;
+        return false;
+    }
+    
+    FFTAnalyzer fftAnalyzer;
+    if (!fftAnalyzer.initialize(m_windowSize, m_hopSize)) {
+        std::cerr << "Failed to initialize FFT analyzer" << std::endl;
+        return false;
+    }
+    
+    BeatDetector beatDetector;
+    if (!beatDetector.initialize(m_beatSensitivity)) {
+        std::cerr << "Failed to initialize beat detector" << std::endl;
+        return false;
+    }
+    
+    if (!beatDetector.initializeOnsetDetection(
+            audioBuffer.getSampleRate(), m_windowSize, m_hopSize)) {
+        std::cerr << "Failed to initialize onset detection" << std::endl;
+        return false;
+    }
+    
+    std::ofstream output(outputPath);
+    if (!output.is_open()) {
+        std::cerr << "Failed to open analysis output: " << outputPath << std::endl;
+        return false;
+    }
+    
+    const int sampleRate = audioBuffer.getSampleRate();
+    const int channels = audioBuffer.getChannelCount();
+    const int numBins = fftAnalyzer.getNumBins();
+    
+    // CSV header: one column per spectrum bin
+    output << "frame,time,beat,onset,energy,bpm,beat_phase";
+    for (int i = 0; i < numBins; ++i) {
+        output << ",bin" << i;
+    }
+    output << "\n";
+    output.precision(5);
+    
+    const size_t blockSamples = static_cast<size_t>(kBlockFrames) * channels;
+    std::vector<float> chunk(blockSamples * kBlocksPerChunk);
+    std::vector<float> block(blockSamples);
+    size_t frameIndex = 0;
+    size_t framesAnalyzed = 0;
+    
+    auto startTime = std::chrono::steady_clock::now();
+    
+    // Pull chunks straight from the buffer, no device pacing
+    while (true) {
+        size_t samplesRead = audioBuffer.readSamples(chunk.data(), chunk.size());
+        if (samplesRead == 0) {
+            break;
+        }
+        
+        // Transform every hop in the chunk through the batched FFT at once
+        int hops = fftAnalyzer.processAudioData(chunk.data(), samplesRead / channels, channels);
+        int hop = 0;
+        
+        // The beat detector still sees the live block size; each hop's row is
+        // written after the block it ends in, and the block's beat flag goes on
+        // its first hop
+        for (size_t offset = 0; offset < samplesRead; offset += blockSamples) {
+            size_t count = std::min(blockSamples, samplesRead - offset);
+            block.assign(chunk.begin() + offset, chunk.begin() + offset + count);
+            beatDetector.analyzeAudio(block, channels);
+            
+            size_t blockEnd = framesAnalyzed + (offset + count) / channels;
+            bool firstHop = true;
+            
+            for (; hop < hops && (frameIndex + 1) * m_hopSize <= blockEnd; ++hop) {
+                const float* spectrum = fftAnalyzer.getFrameSpectrum(hop);
+                float time = static_cast<float>((frameIndex + 1) * m_hopSize) / sampleRate;
+                bool beat = firstHop && beatDetector.isBeatDetected();
+                firstHop = false;
+                
+                // Spectral-flux onsets are reported one hop late, at this row
+                bool onset = beatDetector.analyzeSpectrum(fftAnalyzer.getFrameLinearSpectrum(hop));
+                
+                output << frameIndex << ',' << time << ','
+                       << (beat ? 1 : 0) << ','
+                       << (onset ? 1 : 0) << ','
+                       << beatDetector.getEnergy() << ','
+                       << beatDetector.getTempo() << ','
+                       << beatDetector.getBeatPhase();
+                for (int i = 0; i < numBins; ++i) {
+                    output << ',' << spectrum[i];
+                }
+                output << '\n';
+                
+                ++frameIndex;
+            }
+        }
+        
+        framesAnalyzed += samplesRead / channels;
+        
+        if (samplesRead < chunk.size()) {
+            break;
+        }
+    }
+    
+    output.close();
+    
+    auto endTime = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(endTime - startTime).count();
+    double audioDuration = static_cast<double>(framesAnalyzed) / sampleRate;
+    
+    std::cout << "Analyzed " << frameIndex << " frames (" << audioDuration << " s of audio) in "
+              << elapsed << " s" << std::endl;
+    if (elapsed > 0.0) {
+        std::cout << "Throughput: " << audioDuration / elapsed << "x real time" << std::endl;
+    }
+    std::cout << "Analysis written to: " << outputPath << std::endl;
+    
+    return true;
+}
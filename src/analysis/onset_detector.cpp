@@ -0,0 +1,146 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include "analysis/onset_detector.h"
+
+// Number of log bands the flux is summed over
+static const int kOnsetBands = 24;
+
+// Length of the adaptive threshold window in seconds
+static const float kThresholdWindowSeconds = 0.5f;
+
+// Shortest allowed gap between onsets in seconds
+static const float kMinOnsetIntervalSeconds = 0.08f;
+
+// Flux below this never counts as an onset, keeps silence quiet
+static const float kMinThreshold = 0.01f;
+
+OnsetDetector::OnsetDetector()
+    : m_historyIndex(0)
+    , m_historyCount(0)
+    , m_historySum(0.0f)
+    , m_flux(0.0f)
+    , m_previousFlux(0.0f)
+    , m_olderFlux(0.0f)
+    , m_sensitivity(0.25f)
+    , m_threshold(kMinThreshold)
+    , m_minIntervalHops(1)
+    , m_hopsSinceOnset(0)
+    , m_framesSeen(0)
+{
+}
+
+OnsetDetector::~OnsetDetector() {
+}
+
+bool OnsetDetector::initialize(int sampleRate, int fftSize, int hopSize, float sensitivity) {
+    if (hopSize <= 0) {
+        std::cerr << "Invalid onset detector hop size: " << hopSize << std::endl;
+        return false;
+    }
+
+    if (!m_filterbank.initialize(sampleRate, fftSize, kOnsetBands, FilterbankScale::Log)) {
+        return false;
+    }
+
+    const float hopsPerSecond = static_cast<float>(sampleRate) / hopSize;
+    int windowHops = std::max(3, static_cast<int>(std::lround(kThresholdWindowSeconds * hopsPerSecond)));
+
+    m_bands.assign(kOnsetBands, 0.0f);
+    m_previousBands.assign(kOnsetBands, 0.0f);
+    m_fluxHistory.assign(windowHops, 0.0f);
+    m_medianScratch.assign(windowHops, 0.0f);
+    m_minIntervalHops = std::max(1, static_cast<int>(std::lround(kMinOnsetIntervalSeconds * hopsPerSecond)));
+    m_sensitivity = sensitivity;
+
+    reset();
+
+    return true;
+}
+
+bool OnsetDetector::processFrame(const float* spectrum) {
+    if (m_fluxHistory.empty() || !spectrum) {
+        return false;
+    }
+
+    m_filterbank.apply(spectrum, m_bands.data());
+
+    // Sum of the positive band differences, averaged so the scale does not
+    // depend on the band count; the very first hop only primes the bands
+    float flux = 0.0f;
+    if (m_framesSeen > 0) {
+        for (int band = 0; band < kOnsetBands; ++band) {
+            flux += std::max(0.0f, m_bands[band] - m_previousBands[band]);
+        }
+        flux /= kOnsetBands;
+    }
+    m_previousBands.swap(m_bands);
+
+    m_olderFlux = m_previousFlux;
+    m_previousFlux = m_flux;
+    m_flux = flux;
+    ++m_framesSeen;
+    ++m_hopsSinceOnset;
+
+    // Add to the threshold window
+    const int windowSize = static_cast<int>(m_fluxHistory.size());
+    m_historySum += flux - m_fluxHistory[m_historyIndex];
+    m_fluxHistory[m_historyIndex] = flux;
+    m_historyIndex = (m_historyIndex + 1) % windowSize;
+    m_historyCount = std::min(m_historyCount + 1, windowSize);
+
+    if (m_framesSeen < 3) {
+        return false;
+    }
+
+    // The previous hop is a candidate if it is a local maximum of the flux
+    bool isPeak = m_previousFlux > m_olderFlux && m_previousFlux >= m_flux;
+    if (!isPeak || m_hopsSinceOnset <= m_minIntervalHops) {
+        return false;
+    }
+
+    float mean = std::max(0.0f, m_historySum) / m_historyCount;
+    m_threshold = std::max(kMinThreshold, computeMedian() + m_sensitivity * mean);
+
+    if (m_previousFlux <= m_threshold) {
+        return false;
+    }
+
+    m_hopsSinceOnset = 0;
+    return true;
+}
+
+void OnsetDetector::reset() {
+    std::fill(m_bands.begin(), m_bands.end(), 0.0f);
+    std::fill(m_previousBands.begin(), m_previousBands.end(), 0.0f);
+    std::fill(m_fluxHistory.begin(), m_fluxHistory.end(), 0.0f);
+    m_historyIndex = 0;
+    m_historyCount = 0;
+    m_historySum = 0.0f;
+    m_flux = 0.0f;
+    m_previousFlux = 0.0f;
+    m_olderFlux = 0.0f;
+    m_threshold = kMinThreshold;
+    m_hopsSinceOnset = m_minIntervalHops + 1;
+    m_framesSeen = 0;
+}
+
+float OnsetDetector::getFlux() const {
+    return m_flux;
+}
+
+float OnsetDetector::getThreshold() const {
+    return m_threshold;
+}
+
+int OnsetDetector::getLatencyHops() const {
+    return 1;
+}
+
+float OnsetDetector::computeMedian() {
+    // Partial sort of a scratch copy, the window is only a few dozen hops
+    std::copy_n(m_fluxHistory.begin(), m_historyCount, m_medianScratch.begin());
+    auto middle = m_medianScratch.begin() + m_historyCount / 2;
+    std::nth_element(m_medianScratch.begin(), middle, m_medianScratch.begin() + m_historyCount);
+    return *middle;
+}
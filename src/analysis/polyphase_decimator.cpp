@@ -0,0 +1,107 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include "analysis/polyphase_decimator.h"
+#include "analysis/dsp_kernels.h"
+
+// Cutoff as a fraction of the decimated Nyquist frequency, leaves room for
+// the transition band below the first alias
+static const double kCutoffFraction = 0.9;
+
+PolyphaseDecimator::PolyphaseDecimator()
+    : m_factor(1)
+    , m_tapsPerPhase(0)
+    , m_position(0)
+    , m_phase(0)
+{
+}
+
+PolyphaseDecimator::~PolyphaseDecimator() {
+}
+
+bool PolyphaseDecimator::initialize(int factor, int tapsPerPhase) {
+    if (factor < 1 || tapsPerPhase < 1) {
+        std::cerr << "Invalid decimation factor " << factor
+                  << " or taps per phase " << tapsPerPhase << std::endl;
+        return false;
+    }
+
+    m_factor = factor;
+    m_tapsPerPhase = tapsPerPhase;
+
+    // Blackman-windowed sinc prototype with unity gain at DC
+    const int taps = factor * tapsPerPhase;
+    const double cutoff = kCutoffFraction * 0.5 / factor;
+    std::vector<double> prototype(taps);
+    double total = 0.0;
+    for (int j = 0; j < taps; ++j) {
+        double t = j - (taps - 1) * 0.5;
+        double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        double phase = taps > 1 ? 2.0 * M_PI * j / (taps - 1) : 0.0;
+        double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        prototype[j] = sinc * window;
+        total += prototype[j];
+    }
+
+    // Sub-filter p takes taps p, p + factor, p + 2 * factor, ...
+    m_coefficients.resize(static_cast<size_t>(taps));
+    for (int p = 0; p < factor; ++p) {
+        for (int i = 0; i < tapsPerPhase; ++i) {
+            m_coefficients[p * tapsPerPhase + i] =
+                static_cast<float>(prototype[(tapsPerPhase - 1 - i) * factor + p] / total);
+        }
+    }
+
+    m_delayLines.assign(static_cast<size_t>(factor) * tapsPerPhase * 2, 0.0f);
+    reset();
+
+    return true;
+}
+
+size_t PolyphaseDecimator::process(const float* input, size_t count, float* output) {
+    if (m_tapsPerPhase == 0) {
+        return 0;
+    }
+
+    const int lineLength = m_tapsPerPhase * 2;
+    size_t produced = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        // Each group of factor inputs goes to the phases from factor - 1 down
+        // to 0, so phase p always holds the input p samples before the output
+        float* line = m_delayLines.data() + static_cast<size_t>(m_phase) * lineLength;
+        line[m_position] = input[i];
+        line[m_position + m_tapsPerPhase] = input[i];
+
+        if (m_phase > 0) {
+            --m_phase;
+            continue;
+        }
+
+        // The group is complete: sum the sub-filters over their newest taps
+        float sum = 0.0f;
+        for (int p = 0; p < m_factor; ++p) {
+            sum += dsp::dotProduct(
+                m_delayLines.data() + static_cast<size_t>(p) * lineLength + m_position + 1,
+                m_coefficients.data() + static_cast<size_t>(p) * m_tapsPerPhase,
+                m_tapsPerPhase
+            );
+        }
+        output[produced++] = sum;
+
+        m_position = (m_position + 1) % m_tapsPerPhase;
+        m_phase = m_factor - 1;
+    }
+
+    return produced;
+}
+
+void PolyphaseDecimator::reset() {
+    std::fill(m_delayLines.begin(), m_delayLines.end(), 0.0f);
+    m_position = 0;
+    m_phase = m_factor - 1;
+}
+
+int PolyphaseDecimator::getFactor() const {
+    return m_factor;
+}
@@ -0,0 +1,202 @@
+#include <iostream>
+#include <utility>
+#include "analysis/sliding_median.h"
+
+SlidingMedian::SlidingMedian()
+    : m_lowerCount(0)
+    , m_upperCount(0)
+    , m_nextSlot(0)
+    , m_windowSize(0)
+{
+}
+
+SlidingMedian::~SlidingMedian() {
+}
+
+bool SlidingMedian::initialize(int windowSize) {
+    if (windowSize < 1) {
+        std::cerr << "Invalid sliding median window: " << windowSize << std::endl;
+        return false;
+    }
+
+    m_windowSize = windowSize;
+    m_values.assign(windowSize, 0.0f);
+    // While filling, a value lands in a heap before the sizes are evened
+    // out, so either heap briefly holds one more than its share
+    m_lower.assign(windowSize / 2 + 1, 0);
+    m_upper.assign(windowSize / 2 + 1, 0);
+    m_position.assign(windowSize, 0);
+    reset();
+
+    return true;
+}
+
+float SlidingMedian::push(float value) {
+    if (m_windowSize == 0) {
+        return 0.0f;
+    }
+
+    const int slot = m_nextSlot;
+    m_nextSlot = (m_nextSlot + 1) % m_windowSize;
+
+    if (m_lowerCount + m_upperCount < m_windowSize) {
+        // Still filling: add to the half the value belongs to, then even out
+        // the sizes so the lower half has the extra entry
+        m_values[slot] = value;
+        if (m_lowerCount == 0 || value <= m_values[m_lower[0]]) {
+            m_lower[m_lowerCount] = slot;
+            m_position[slot] = m_lowerCount;
+            siftLower(m_lowerCount++);
+        } else {
+            m_upper[m_upperCount] = slot;
+            m_position[slot] = ~m_upperCount;
+            siftUpper(m_upperCount++);
+        }
+
+        if (m_lowerCount > m_upperCount + 1) {
+            moveLowerToUpper();
+        } else if (m_upperCount > m_lowerCount) {
+            moveUpperToLower();
+        }
+        return getMedian();
+    }
+
+    // Full: the oldest value is replaced where it sits, which keeps both
+    // heap sizes fixed
+    m_values[slot] = value;
+    int position = m_position[slot];
+    if (position >= 0) {
+        siftLower(position);
+    } else {
+        siftUpper(~position);
+    }
+
+    // Only the replaced value can be on the wrong side; if it crossed over,
+    // it is now a root and one swap of the roots puts it back
+    if (m_upperCount > 0 && m_values[m_lower[0]] > m_values[m_upper[0]]) {
+        std::swap(m_lower[0], m_upper[0]);
+        m_position[m_lower[0]] = 0;
+        m_position[m_upper[0]] = ~0;
+        siftLower(0);
+        siftUpper(0);
+    }
+
+    return getMedian();
+}
+
+float SlidingMedian::getMedian() const {
+    if (m_lowerCount == 0) {
+        return 0.0f;
+    }
+    if (m_lowerCount > m_upperCount) {
+        return m_values[m_lower[0]];
+    }
+    return 0.5f * (m_values[m_lower[0]] + m_values[m_upper[0]]);
+}
+
+void SlidingMedian::reset() {
+    m_lowerCount = 0;
+    m_upperCount = 0;
+    m_nextSlot = 0;
+}
+
+int SlidingMedian::getWindowSize() const {
+    return m_windowSize;
+}
+
+void SlidingMedian::siftLower(int index) {
+    // Max-heap: up while larger than the parent, then down while smaller
+    // than the larger child
+    const int slot = m_lower[index];
+    const float value = m_values[slot];
+
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (m_values[m_lower[parent]] >= value) {
+            break;
+        }
+        m_lower[index] = m_lower[parent];
+        m_position[m_lower[index]] = index;
+        index = parent;
+    }
+
+    while (true) {
+        int child = index * 2 + 1;
+        if (child >= m_lowerCount) {
+            break;
+        }
+        if (child + 1 < m_lowerCount && m_values[m_lower[child + 1]] > m_values[m_lower[child]]) {
+            ++child;
+        }
+        if (m_values[m_lower[child]] <= value) {
+            break;
+        }
+        m_lower[index] = m_lower[child];
+        m_position[m_lower[index]] = index;
+        index = child;
+    }
+
+    m_lower[index] = slot;
+    m_position[slot] = index;
+}
+
+void SlidingMedian::siftUpper(int index) {
+    // Min-heap, the mirror image of siftLower
+    const int slot = m_upper[index];
+    const float value = m_values[slot];
+
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (m_values[m_upper[parent]] <= value) {
+            break;
+        }
+        m_upper[index] = m_upper[parent];
+        m_position[m_upper[index]] = ~index;
+        index = parent;
+    }
+
+    while (true) {
+        int child = index * 2 + 1;
+        if (child >= m_upperCount) {
+            break;
+        }
+        if (child + 1 < m_upperCount && m_values[m_upper[child + 1]] < m_values[m_upper[child]]) {
+            ++child;
+        }
+        if (m_values[m_upper[child]] >= value) {
+            break;
+        }
+        m_upper[index] = m_upper[child];
+        m_position[m_upper[index]] = ~index;
+        index = child;
+    }
+
+    m_upper[index] = slot;
+    m_position[slot] = ~index;
+}
+
+void SlidingMedian::moveLowerToUpper() {
+    int slot = m_lower[0];
+    m_lower[0] = m_lower[--m_lowerCount];
+    m_position[m_lower[0]] = 0;
+    if (m_lowerCount > 0) {
+        siftLower(0);
+    }
+
+    m_upper[m_upperCount] = slot;
+    m_position[slot] = ~m_upperCount;
+    siftUpper(m_upperCount++);
+}
+
+void SlidingMedian::moveUpperToLower() {
+    int slot = m_upper[0];
+    m_upper[0] = m_upper[--m_upperCount];
+    m_position[m_upper[0]] = ~0;
+    if (m_upperCount > 0) {
+        siftUpper(0);
+    }
+
+    m_lower[m_lowerCount] = slot;
+    m_position[slot] = m_lowerCount;
+    siftLower(m_lowerCount++);
+}
@@ -0,0 +1,316 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include "analysis/tempo_tracker.h"
+#include "analysis/fft_planner.h"
+
+// Tempo range searched, in BPM
+static const float kMinBpm = 60.0f;
+static const float kMaxBpm = 180.0f;
+
+// Centre and width (in octaves) of the log-Gaussian tempo prior
+static const float kPriorBpm = 120.0f;
+static const float kPriorWidth = 1.0f;
+
+// Seconds between tempo estimates
+static const float kUpdateSeconds = 0.25f;
+
+// Fraction of the phase error corrected at each estimate
+static const double kPhaseGain = 0.5;
+
+TempoTracker::TempoTracker()
+    : m_frameRate(0.0f)
+    , m_envelopeIndex(0)
+    , m_envelopeCount(0)
+    , m_fftSize(0)
+    , m_fftBuffer(nullptr)
+    , m_fftSpectrum(nullptr)
+    , m_forwardPlan(nullptr)
+    , m_inversePlan(nullptr)
+    , m_minLag(1)
+    , m_maxLag(1)
+    , m_updateInterval(1)
+    , m_framesSinceUpdate(0)
+    , m_period(0.0)
+    , m_confidence(0.0f)
+    , m_frameIndex(-1)
+    , m_nextBeat(0.0)
+    , m_lastAnnouncedBeat(-1.0)
+    , m_lookaheadFrames(0.0)
+{
+}
+
+TempoTracker::~TempoTracker() {
+    releaseFFT();
+}
+
+bool TempoTracker::initialize(float frameRate, float windowSeconds) {
+    m_minLag = static_cast<int>(std::floor(60.0f * frameRate / kMaxBpm));
+    m_maxLag = static_cast<int>(std::ceil(60.0f * frameRate / kMinBpm));
+    int windowFrames = static_cast<int>(std::lround(windowSeconds * frameRate));
+
+    // The window has to hold a few beats at the slowest tempo
+    if (frameRate <= 0.0f || m_minLag < 2 || windowFrames < m_maxLag * 2) {
+        std::cerr << "Invalid tempo tracker frame rate " << frameRate
+                  << " or window " << windowSeconds << " s" << std::endl;
+        return false;
+    }
+
+    releaseFFT();
+
+    m_frameRate = frameRate;
+    m_envelope.assign(windowFrames, 0.0f);
+    m_window.assign(windowFrames, 0.0f);
+    m_updateInterval = std::max(1, static_cast<int>(std::lround(kUpdateSeconds * frameRate)));
+
+    // Zero padding to twice the window turns the circular correlation linear
+    m_fftSize = 1;
+    while (m_fftSize < windowFrames * 2) {
+        m_fftSize <<= 1;
+    }
+
+    m_fftBuffer = static_cast<float*>(fftwf_malloc(sizeof(float) * m_fftSize));
+    m_fftSpectrum = static_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * (m_fftSize / 2 + 1)));
+
+    if (!m_fftBuffer || !m_fftSpectrum) {
+        std::cerr << "Failed to allocate memory for tempo tracking" << std::endl;
+        return false;
+    }
+
+    m_forwardPlan = FFTPlanner::createPlan(
+        "r2c " + std::to_string(m_fftSize),
+        [this](unsigned flags) {
+            return fftwf_plan_dft_r2c_1d(m_fftSize, m_fftBuffer, m_fftSpectrum, flags);
+        }
+    );
+    m_inversePlan = FFTPlanner::createPlan(
+        "c2r " + std::to_string(m_fftSize),
+        [this](unsigned flags) {
+            return fftwf_plan_dft_c2r_1d(m_fftSize, m_fftSpectrum, m_fftBuffer, flags);
+        }
+    );
+
+    if (!m_forwardPlan || !m_inversePlan) {
+        std::cerr << "Failed to create tempo tracker FFTW plans" << std::endl;
+        return false;
+    }
+
+    reset();
+
+    return true;
+}
+
+bool TempoTracker::processFrame(float onsetStrength) {
+    if (m_envelope.empty()) {
+        return false;
+    }
+
+    const int windowFrames = static_cast<int>(m_envelope.size());
+    m_envelope[m_envelopeIndex] = onsetStrength;
+    m_envelopeIndex = (m_envelopeIndex + 1) % windowFrames;
+    m_envelopeCount = std::min(m_envelopeCount + 1, windowFrames);
+    ++m_frameIndex;
+
+    // Re-estimate a few times per second once a few slow beats are covered
+    if (++m_framesSinceUpdate >= m_updateInterval && m_envelopeCount >= m_maxLag * 2) {
+        m_framesSinceUpdate = 0;
+        estimateTempo();
+        estimatePhase();
+    }
+
+    if (m_period <= 0.0) {
+        return false;
+    }
+
+    // Free-run the clock between estimates
+    while (m_nextBeat <= m_frameIndex) {
+        m_nextBeat += m_period;
+    }
+
+    // Announce the upcoming beat once, as soon as it falls inside the lookahead
+    double lookahead = std::min(m_lookaheadFrames, m_period * 0.5);
+    if (m_frameIndex + lookahead < m_nextBeat || m_nextBeat - m_lastAnnouncedBeat < m_period * 0.5) {
+        return false;
+    }
+
+    m_lastAnnouncedBeat = m_nextBeat;
+    return true;
+}
+
+void TempoTracker::reset() {
+    std::fill(m_envelope.begin(), m_envelope.end(), 0.0f);
+    m_envelopeIndex = 0;
+    m_envelopeCount = 0;
+    m_framesSinceUpdate = 0;
+    m_period = 0.0;
+    m_confidence = 0.0f;
+    m_frameIndex = -1;
+    m_nextBeat = 0.0;
+    m_lastAnnouncedBeat = -1.0;
+}
+
+void TempoTracker::setLookahead(float seconds) {
+    m_lookaheadFrames = std::max(0.0f, seconds) * m_frameRate;
+}
+
+float TempoTracker::getBpm() const {
+    if (m_period <= 0.0) {
+        return 0.0f;
+    }
+    return static_cast<float>(60.0 * m_frameRate / m_period);
+}
+
+float TempoTracker::getBeatPhase() const {
+    if (m_period <= 0.0) {
+        return 0.0f;
+    }
+    double phase = 1.0 - (m_nextBeat - m_frameIndex) / m_period;
+    return static_cast<float>(std::clamp(phase, 0.0, 1.0));
+}
+
+float TempoTracker::getConfidence() const {
+    return m_confidence;
+}
+
+float TempoTracker::getTimeToNextBeat() const {
+    if (m_period <= 0.0) {
+        return 0.0f;
+    }
+    return static_cast<float>((m_nextBeat - m_frameIndex) / m_frameRate);
+}
+
+void TempoTracker::estimateTempo() {
+    const int windowFrames = static_cast<int>(m_envelope.size());
+    const int count = m_envelopeCount;
+
+    // Unroll the ring oldest first and remove the mean so the correlation
+    // measures periodicity rather than overall level
+    int start = (m_envelopeIndex - count + windowFrames) % windowFrames;
+    float mean = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        m_window[i] = m_envelope[(start + i) % windowFrames];
+        mean += m_window[i];
+    }
+    mean /= count;
+
+    for (int i = 0; i < count; ++i) {
+        m_fftBuffer[i] = m_window[i] - mean;
+    }
+    std::fill(m_fftBuffer + count, m_fftBuffer + m_fftSize, 0.0f);
+
+    // Autocorrelation = inverse FFT of the power spectrum
+    fftwf_execute(m_forwardPlan);
+    const int numBins = m_fftSize / 2 + 1;
+    for (int k = 0; k < numBins; ++k) {
+        float re = m_fftSpectrum[k][0];
+        float im = m_fftSpectrum[k][1];
+        m_fftSpectrum[k][0] = re * re + im * im;
+        m_fftSpectrum[k][1] = 0.0f;
+    }
+    fftwf_execute(m_inversePlan);
+
+    const float energy = m_fftBuffer[0];
+    if (energy <= 0.0f) {
+        m_confidence = 0.0f;
+        return;
+    }
+
+    // Unbiased, normalized correlation at each lag weighted by the tempo prior
+    int maxLag = std::min(m_maxLag, count - 1);
+    int bestLag = 0;
+    float bestScore = 0.0f;
+    for (int lag = m_minLag; lag <= maxLag; ++lag) {
+        float correlation = m_fftBuffer[lag] / energy * count / (count - lag);
+        float octaves = std::log2(60.0f * m_frameRate / lag / kPriorBpm) / kPriorWidth;
+        float score = correlation * std::exp(-0.5f * octaves * octaves);
+        if (score > bestScore) {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+
+    if (bestLag == 0) {
+        m_confidence = 0.0f;
+        return;
+    }
+
+    // Parabolic interpolation for a fractional period
+    double period = bestLag;
+    if (bestLag > m_minLag && bestLag < maxLag) {
+        double left = m_fftBuffer[bestLag - 1];
+        double center = m_fftBuffer[bestLag];
+        double right = m_fftBuffer[bestLag + 1];
+        double denominator = left - 2.0 * center + right;
+        if (denominator < 0.0) {
+            period += std::clamp(0.5 * (left - right) / denominator, -0.5, 0.5);
+        }
+    }
+
+    float correlation = m_fftBuffer[bestLag] / energy * count / (count - bestLag);
+    m_confidence = std::clamp(correlation, 0.0f, 1.0f);
+
+    // Follow small drifts smoothly, jump on a real tempo change
+    if (m_period > 0.0 && std::fabs(period - m_period) < m_period * 0.05) {
+        m_period = 0.8 * m_period + 0.2 * period;
+    } else {
+        m_period = period;
+    }
+}
+
+void TempoTracker::estimatePhase() {
+    if (m_period <= 0.0) {
+        return;
+    }
+
+    const int count = m_envelopeCount;
+    const int periodFrames = static_cast<int>(std::lround(m_period));
+
+    // Sum the envelope along a comb of beats ending at each candidate offset
+    // from the newest frame (window index count - 1, frame m_frameIndex);
+    // the best offset is where the last beat was
+    int bestOffset = 0;
+    float bestScore = -1.0f;
+    for (int offset = 0; offset < periodFrames; ++offset) {
+        float score = 0.0f;
+        for (double position = count - 1 - offset; position >= 0.0; position -= m_period) {
+            score += m_window[static_cast<int>(position)];
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            bestOffset = offset;
+        }
+    }
+
+    double estimatedBeat = static_cast<double>(m_frameIndex - bestOffset) + m_period;
+
+    if (m_lastAnnouncedBeat < 0.0) {
+        m_nextBeat = estimatedBeat;
+        return;
+    }
+
+    // Pull the running clock towards the estimate by the shortest way round
+    double error = std::remainder(estimatedBeat - m_nextBeat, m_period);
+    m_nextBeat += kPhaseGain * error;
+}
+
+void TempoTracker::releaseFFT() {
+    if (m_forwardPlan) {
+        fftwf_destroy_plan(m_forwardPlan);
+        m_forwardPlan = nullptr;
+    }
+
+    if (m_inversePlan) {
+        fftwf_destroy_plan(m_inversePlan);
+        m_inversePlan = nullptr;
+    }
+
+    if (m_fftBuffer) {
+        fftwf_free(m_fftBuffer);
+        m_fftBuffer = nullptr;
+    }
+
+    if (m_fftSpectrum) {
+        fftwf_free(m_fftSpectrum);
+        m_fftSpectrum = nullptr;
+    }
+}
@@ -2,10 +2,19 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <algorithm>
 #include "audio/audio_buffer.h"
+#include "audio/stream_decoder.h"
+#include "audio/pcm_cache.h"
+
+// Streaming decodes 16k-frame chunks and keeps at most 8 of them queued
+static const size_t kStreamChunkFrames = 16384;
+static const size_t kStreamPrefetchChunks = 8;
 
 AudioBuffer::AudioBuffer()
-    : m_position(0)
+    : m_samples(nullptr)
+    , m_sampleCount(0)
+    , m_position(0)
     , m_sampleRate(44100)
     , m_channelCount(2)
 {
@@ -14,8 +23,19 @@ AudioBuffer::AudioBuffer()
 AudioBuffer::~AudioBuffer() {
 }
 
-bool AudioBuffer::loadFromFile(const std::string& filePath) {
+bool AudioBuffer::loadFromFile(const std::string& filePath, bool storeInCache) {
+    // Drop the previous track, whichever way it was loaded
+    m_streamDecoder.reset();
+    m_pcmCache.reset();
+    m_samples = nullptr;
+    m_sampleCount = 0;
+    
 #ifdef USE_LIBSNDFILE
+    // Previously decoded tracks load at page-fault cost
+    if (loadFromCache(filePath)) {
+        return true;
+    }
+    
     std::cout << "Using libsndfile to load: " << filePath << std::endl;
     
     // Open sound file
@@ -44,9 +64,15 @@ bool AudioBuffer::loadFromFile(const std::string& filePath) {
         return false;
     }
     
+    // Save the decoded samples so the next load can map them directly
+    if (storeInCache && !PcmCache::store(filePath, buffer.data(), buffer.size(), m_sampleRate, m_channelCount)) {
+        std::cerr << "Could not cache decoded audio for: " << filePath << std::endl;
+    }
+    
     // Store the audio data
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_audioData = buffer;
+    m_audioData.swap(buffer);
+    m_samples = m_audioData.data();
+    m_sampleCount = m_audioData.size();
     m_position = 0;
     
     std::cout << "Loaded audio file: " << filePath << std::endl;
@@ -69,7 +95,6 @@ bool AudioBuffer::loadFromFile(const std::string& filePath) {
     
     size_t numSamples = static_cast<size_t>(m_sampleRate * duration * m_channelCount);
     
-    std::lock_guard<std::mutex> lock(m_mutex);
     m_audioData.resize(numSamples);
     
     for (size_t i = 0; i < numSamples; i += m_channelCount) {
@@ -82,6 +107,8 @@ bool AudioBuffer::loadFromFile(const std::string& filePath) {
         }
     }
     
+    m_samples = m_audioData.data();
+    m_sampleCount = m_audioData.size();
     m_position = 0;
     
     std::cout << "Created test audio: " << duration << " seconds, "
@@ -91,35 +118,113 @@ bool AudioBuffer::loadFromFile(const std::string& filePath) {
 #endif
 }
 
+bool AudioBuffer::openStream(const std::string& filePath) {
+    // A cached track is already decoded, mapping it beats streaming
+    if (loadFromCache(filePath)) {
+        return true;
+    }
+    
+    auto decoder = std::make_unique<StreamDecoder>();
+    if (!decoder->open(filePath, kStreamChunkFrames, kStreamPrefetchChunks)) {
+        return false;
+    }
+    
+    m_sampleRate = decoder->getSampleRate();
+    m_channelCount = decoder->getChannelCount();
+    m_streamDecoder = std::move(decoder);
+    
+    // Release any fully loaded or mapped track
+    std::vector<float>().swap(m_audioData);
+    m_pcmCache.reset();
+    m_samples = nullptr;
+    m_sampleCount = 0;
+    m_position = 0;
+    
+    return true;
+}
+
 std::vector<float> AudioBuffer::getSamples(size_t numSamples) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<float> samples(numSamples);
+    samples.resize(readSamples(samples.data(), numSamples));
+    return samples;
+}
+
+size_t AudioBuffer::readSamples(float* dest, size_t numSamples, bool* atEnd) {
+    if (m_streamDecoder) {
+        size_t samplesRead = m_streamDecoder->readSamples(dest, numSamples);
+        if (atEnd) {
+            *atEnd = m_streamDecoder->isFinished();
+        }
+        return samplesRead;
+    }
     
-    if (m_position >= m_audioData.size()) {
+    // Only this call advances the position, so one load and one store do
+    size_t position = m_position.load(std::memory_order_relaxed);
+    if (position >= m_sampleCount) {
         // End of audio
-        return std::vector<float>();
+        if (atEnd) {
+            *atEnd = true;
+        }
+        return 0;
     }
     
-    size_t samplesAvailable = m_audioData.size() - m_position;
+    size_t samplesAvailable = m_sampleCount - position;
     size_t samplesToReturn = std::min(numSamples, samplesAvailable);
     
-    std::vector<float> samples(samplesToReturn);
-    
     // Copy samples
     memcpy(
-        samples.data(),
-        m_audioData.data() + m_position,
+        dest,
+        m_samples + position,
         samplesToReturn * sizeof(float)
     );
     
     // Update position
-    m_position += samplesToReturn;
+    position += samplesToReturn;
+    m_position.store(position, std::memory_order_relaxed);
     
-    return samples;
+    if (atEnd) {
+        *atEnd = position >= m_sampleCount;
+    }
+    return samplesToReturn;
 }
 
 void AudioBuffer::reset() {
-    std::lock_guard<std::mutex> lock(m_mutex);
     m_position = 0;
+    
+    if (m_streamDecoder) {
+        m_streamDecoder->rewind();
+    }
+}
+
+bool AudioBuffer::isAtEnd() const {
+    if (m_streamDecoder) {
+        return m_streamDecoder->isFinished();
+    }
+    
+    return m_position >= m_sampleCount;
+}
+
+bool AudioBuffer::loadFromCache(const std::string& filePath) {
+    auto cache = std::make_unique<PcmCache>();
+    if (!cache->open(filePath)) {
+        return false;
+    }
+    
+    m_streamDecoder.reset();
+    std::vector<float>().swap(m_audioData);
+    
+    m_sampleRate = cache->getSampleRate();
+    m_channelCount = cache->getChannelCount();
+    m_samples = cache->getSamples();
+    m_sampleCount = cache->getSampleCount();
+    m_pcmCache = std::move(cache);
+    m_position = 0;
+    
+    std::cout << "Loaded cached audio: " << filePath << std::endl;
+    std::cout << "Sample rate: " << m_sampleRate << ", Channels: " << m_channelCount << std::endl;
+    std::cout << "Duration: " << float(m_sampleCount / m_channelCount) / m_sampleRate << " seconds" << std::endl;
+    
+    return true;
 }
 
 int AudioBuffer::getSampleRate() const {
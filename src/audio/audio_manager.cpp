@@ -3,6 +3,10 @@
 #include <cstring>
 #include "audio/audio_manager.h"
 #include "audio/audio_buffer.h"
+#include "audio/sample_ring.h"
+
+// About 0.75 seconds of stereo audio at 44.1 kHz
+static const size_t kSampleRingCapacity = 1 << 16;
 
 AudioManager::AudioManager()
     : m_stream(nullptr)
@@ -12,6 +16,7 @@ AudioManager::AudioManager()
     , m_bufferSize(1024)
     , m_isCapturingInput(false)
     , m_isPlaying(false)
+    , m_sampleRing(std::make_unique<SampleRing>(kSampleRingCapacity))
 {
 }
 
@@ -83,7 +88,7 @@ void AudioManager::closeStream() {
     }
 }
 
-bool AudioManager::loadFile(const std::string& filePath) {
+bool AudioManager::loadFile(const std::string& filePath, bool streaming) {
     // Close existing stream
     closeStream();
     
@@ -91,8 +96,14 @@ bool AudioManager::loadFile(const std::string& filePath) {
     m_isCapturingInput = false;
     m_isPlaying = false;
     
+    // No callback is running now, so the ring can be cleared safely
+    m_sampleRing->reset();
+    
     // Load audio file
-    if (!m_audioBuffer->loadFromFile(filePath)) {
+    bool loaded = streaming
+        ? m_audioBuffer->openStream(filePath)
+        : m_audioBuffer->loadFromFile(filePath);
+    if (!loaded) {
         std::cerr << "Failed to load audio file: " << filePath << std::endl;
         return false;
     }
@@ -142,7 +153,7 @@ bool AudioManager::loadFile(const std::string& filePath) {
     return true;
 }
 
-bool AudioManager::startInputCapture() {
+bool AudioManager::openInputCapture(int channels) {
     // Close existing stream
     closeStream();
     
@@ -150,6 +161,9 @@ bool AudioManager::startInputCapture() {
     m_isCapturingInput = true;
     m_isPlaying = false;
     
+    // No callback is running now, so the ring can be cleared safely
+    m_sampleRing->reset();
+    
     // Try to find the PulseAudio API
     PaHostApiIndex pulseIndex = -1;
     for (int i = 0; i < Pa_GetHostApiCount(); i++) {
@@ -181,7 +195,19 @@ bool AudioManager::startInputCapture() {
         return false;
     }
     
-    m_channelCount = 2; // Stereo input
+    int deviceChannels = Pa_GetDeviceInfo(inputParams.device)->maxInputChannels;
+    if (channels < 1 || deviceChannels < 1) {
+        std::cerr << "Invalid input channel count " << channels
+                  << " (device has " << deviceChannels << ")" << std::endl;
+        return false;
+    }
+    if (channels > deviceChannels) {
+        std::cout << "Input device has only " << deviceChannels << " channels, capturing "
+                  << deviceChannels << " instead of " << channels << std::endl;
+        channels = deviceChannels;
+    }
+    
+    m_channelCount = channels;
     inputParams.channelCount = m_channelCount;
     inputParams.sampleFormat = paFloat32;
     inputParams.suggestedLatency = Pa_GetDeviceInfo(inputParams.device)->defaultLowInputLatency;
@@ -203,25 +229,13 @@ bool AudioManager::startInputCapture() {
         return false;
     }
     
-    // Start the stream
-    err = Pa_StartStream(m_stream);
-    if (err != paNoError) {
-        std::cerr << "Error starting PortAudio stream: " << Pa_GetErrorText(err) << std::endl;
-        closeStream();
-        return false;
-    }
-    
-    m_isPlaying = true;
-    std::cout << "Audio input capture started" << std::endl;
+    std::cout << "Audio input opened with " << m_channelCount << " channels ("
+              << getChannelLayout().describe() << ")" << std::endl;
     
     return true;
 }
 
 bool AudioManager::play() {
-    if (m_isCapturingInput) {
-        return true; // Already capturing, nothing to do
-    }
-    
     if (m_isPlaying) {
         return true; // Already playing, nothing to do
     }
@@ -238,7 +252,7 @@ bool AudioManager::play() {
     }
     
     m_isPlaying = true;
-    std::cout << "Audio playback started" << std::endl;
+    std::cout << (m_isCapturingInput ? "Audio input capture started" : "Audio playback started") << std::endl;
     
     return true;
 }
@@ -273,8 +287,39 @@ void AudioManager::togglePlayback() {
 }
 
 std::vector<float> AudioManager::getAudioSamples() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_currentSamples;
+    // Return the most recent callback-sized block
+    std::vector<float> samples(static_cast<size_t>(m_bufferSize) * m_channelCount);
+    size_t count = m_sampleRing->readLatest(samples.data(), samples.size());
+    samples.resize(count);
+    return samples;
+}
+
+size_t AudioManager::readNewSamples(std::vector<float>& samples) {
+    samples.resize(m_sampleRing->getReadAvailable());
+    samples.resize(m_sampleRing->read(samples.data(), samples.size()));
+    return samples.size();
+}
+
+size_t AudioManager::getLatestSamples(std::vector<float>& samples) {
+    samples.resize(static_cast<size_t>(m_bufferSize) * m_channelCount);
+    samples.resize(m_sampleRing->peekLatest(samples.data(), samples.size()));
+    return samples.size();
+}
+
+int AudioManager::getBufferSize() const {
+    return m_bufferSize;
+}
+
+SampleRing& AudioManager::getSampleRing() {
+    return *m_sampleRing;
+}
+
+uint64_t AudioManager::getOverrunCount() const {
+    return m_sampleRing->getOverrunCount();
+}
+
+uint64_t AudioManager::getUnderrunCount() const {
+    return m_sampleRing->getUnderrunCount();
 }
 
 int AudioManager::getSampleRate() const {
@@ -285,6 +330,10 @@ int AudioManager::getChannelCount() const {
     return m_channelCount;
 }
 
+ChannelLayout AudioManager::getChannelLayout() const {
+    return ChannelLayout::forChannelCount(m_channelCount);
+}
+
 int AudioManager::audioCallback(
     const void* inputBuffer,
     void* outputBuffer,
@@ -300,14 +349,10 @@ int AudioManager::audioCallback(
         if (inputBuffer) {
             const float* in = static_cast<const float*>(inputBuffer);
             
-            std::lock_guard<std::mutex> lock(audioManager->m_mutex);
-            audioManager->m_currentSamples.resize(framesPerBuffer * audioManager->m_channelCount);
-            
-            // Copy input data
-            memcpy(
-                audioManager->m_currentSamples.data(),
+            // Publish input data to the main loop without locking
+            audioManager->m_sampleRing->write(
                 in,
-                framesPerBuffer * audioManager->m_channelCount * sizeof(float)
+                framesPerBuffer * audioManager->m_channelCount
             );
         }
     } else {
@@ -315,25 +360,23 @@ int AudioManager::audioCallback(
         if (outputBuffer) {
             float* out = static_cast<float*>(outputBuffer);
             
-            // Get samples from audio buffer
-            std::vector<float> samples = audioManager->m_audioBuffer->getSamples(
-                framesPerBuffer * audioManager->m_channelCount
-            );
+            size_t samplesWanted = framesPerBuffer * audioManager->m_channelCount;
             
-            // Copy to output buffer
-            memcpy(
-                out,
-                samples.data(),
-                samples.size() * sizeof(float)
-            );
+            // Copy file samples straight into the device buffer, learning in
+            // the same call whether the track is over
+            bool atEnd = false;
+            size_t samplesRead = audioManager->m_audioBuffer->readSamples(out, samplesWanted, &atEnd);
             
-            {
-                std::lock_guard<std::mutex> lock(audioManager->m_mutex);
-                audioManager->m_currentSamples = samples;
+            // Silence whatever the file could not fill
+            if (samplesRead < samplesWanted) {
+                memset(out + samplesRead, 0, (samplesWanted - samplesRead) * sizeof(float));
             }
             
-            // Check for end of file
-            if (samples.size() < framesPerBuffer * audioManager->m_channelCount) {
+            // Publish the same block to the main loop without locking
+            audioManager->m_sampleRing->write(out, samplesRead);
+            
+            // Check for end of file, a short read while streaming may just be a decoder stall
+            if (samplesRead < samplesWanted && atEnd) {
                 return paComplete;
             }
         }
@@ -0,0 +1,52 @@
+#include "audio/channel_layout.h"
+
+ChannelLayout ChannelLayout::forChannelCount(int channels) {
+    ChannelLayout layout;
+    layout.channels = channels;
+
+    switch (channels) {
+        case 1:
+            layout.names = {"M"};
+            break;
+        case 2:
+            layout.names = {"L", "R"};
+            break;
+        case 4:
+            layout.names = {"FL", "FR", "RL", "RR"};
+            break;
+        case 6:
+            layout.names = {"FL", "FR", "C", "LFE", "SL", "SR"};
+            break;
+        case 8:
+            layout.names = {"FL", "FR", "C", "LFE", "RL", "RR", "SL", "SR"};
+            break;
+        default:
+            for (int c = 0; c < channels; ++c) {
+                layout.names.push_back(std::to_string(c + 1));
+            }
+            break;
+    }
+
+    // Every layout with two or more channels starts with its front pair
+    if (channels < 2) {
+        layout.left = -1;
+        layout.right = -1;
+    }
+
+    return layout;
+}
+
+bool ChannelLayout::hasStereoPair() const {
+    return left >= 0 && right >= 0 && left < channels && right < channels && left != right;
+}
+
+std::string ChannelLayout::describe() const {
+    std::string description;
+    for (const std::string& name : names) {
+        if (!description.empty()) {
+            description += ' ';
+        }
+        description += name;
+    }
+    return description;
+}
@@ -0,0 +1,312 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include <filesystem>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "audio/pcm_cache.h"
+#include "util/cache_directory.h"
+
+// Fixed 64-byte header in front of the sample data, keeps samples aligned
+struct PcmCacheHeader {
+    char magic[8];          // "MVPCM" padded with zeros
+    uint32_t version;       // Format version
+    uint32_t sampleRate;    // Sample rate in Hz
+    uint32_t channelCount;  // Interleaved channel count
+    uint32_t sampleFormat;  // 0 = float32
+    uint64_t sampleCount;   // Total samples (frames * channels)
+    uint64_t sourceSize;    // Size of the source file in bytes
+    int64_t sourceMtime;    // Modification time of the source in nanoseconds
+    uint64_t pathHash;      // Hash of the canonical source path
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(PcmCacheHeader) == 64, "PCM cache header must stay 64 bytes");
+
+static const char kPcmCacheMagic[8] = {'M', 'V', 'P', 'C', 'M', 0, 0, 0};
+static const uint32_t kPcmCacheVersion = 1;
+static const uint32_t kSampleFormatFloat32 = 0;
+
+// Total size the cache entries may take on disk, about 20 stereo tracks of
+// five minutes; the least recently used entries are evicted beyond it
+static const uint64_t kMaxCacheBytes = 2ull << 30;
+
+// Extension of cache entries, temporary files carry a suffix after it
+static const char kPcmCacheExtension[] = ".pcm";
+
+// Canonical form of a path so different spellings share one entry
+static std::string canonicalPath(const std::string& path) {
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    if (error) {
+        return path;
+    }
+    return canonical.string();
+}
+
+// 64-bit FNV-1a, stable across builds unlike std::hash
+static uint64_t hashPath(const std::string& path) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : path) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Remove the least recently used entries until the cache fits in limit
+// bytes. Entries are touched on every hit, so their modification time is the
+// time of last use. keepPath is never removed.
+static void evictEntries(const std::string& directory, const std::string& keepPath, uint64_t limit) {
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUse;
+        uint64_t size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code error;
+    for (const auto& item : std::filesystem::directory_iterator(directory, error)) {
+        std::error_code itemError;
+        if (!item.is_regular_file(itemError) || item.path().extension() != kPcmCacheExtension) {
+            continue;
+        }
+        Entry entry;
+        entry.path = item.path();
+        entry.lastUse = item.last_write_time(itemError);
+        entry.size = item.file_size(itemError);
+        if (itemError) {
+            continue;
+        }
+        total += entry.size;
+        entries.push_back(entry);
+    }
+
+    if (total <= limit) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.lastUse < b.lastUse;
+    });
+
+    for (const Entry& entry : entries) {
+        if (total <= limit) {
+            break;
+        }
+        if (entry.path.string() == keepPath) {
+            continue;
+        }
+        if (std::filesystem::remove(entry.path, error)) {
+            total -= entry.size;
+        }
+    }
+}
+
+// Get size and modification time of a source file
+static bool statSource(const std::string& path, uint64_t& size, int64_t& mtime) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000ll + info.st_mtim.tv_nsec;
+    return true;
+}
+
+PcmCache::PcmCache()
+    : m_mapping(nullptr)
+    , m_mappingSize(0)
+    , m_samples(nullptr)
+    , m_sampleCount(0)
+    , m_sampleRate(0)
+    , m_channelCount(0)
+{
+}
+
+PcmCache::~PcmCache() {
+    close();
+}
+
+bool PcmCache::open(const std::string& sourcePath) {
+    close();
+
+    std::string cachePath = getCachePath(sourcePath);
+    if (cachePath.empty()) {
+        return false;
+    }
+
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    if (!statSource(sourcePath, sourceSize, sourceMtime)) {
+        return false;
+    }
+
+    int fd = ::open(cachePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(PcmCacheHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map PCM cache: " << cachePath << std::endl;
+        return false;
+    }
+
+    const PcmCacheHeader* header = static_cast<const PcmCacheHeader*>(mapping);
+
+    // The sample count is checked by dividing the payload size, so a
+    // corrupt header cannot overflow the expected file size
+    size_t payloadSize = fileSize - sizeof(PcmCacheHeader);
+
+    // Reject entries from another format or a source that has since changed
+    bool valid = memcmp(header->magic, kPcmCacheMagic, sizeof(kPcmCacheMagic)) == 0
+        && header->version == kPcmCacheVersion
+        && header->sampleFormat == kSampleFormatFloat32
+        && header->sourceSize == sourceSize
+        && header->sourceMtime == sourceMtime
+        && header->pathHash == hashPath(canonicalPath(sourcePath))
+        && header->channelCount > 0
+        && payloadSize % sizeof(float) == 0
+        && header->sampleCount == payloadSize / sizeof(float);
+
+    if (!valid) {
+        munmap(mapping, fileSize);
+        return false;
+    }
+
+    // Playback walks the samples front to back
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+
+    // Mark the entry as recently used for eviction
+    utimes(cachePath.c_str(), nullptr);
+
+    m_mapping = mapping;
+    m_mappingSize = fileSize;
+    m_samples = reinterpret_cast<const float*>(static_cast<const char*>(mapping) + sizeof(PcmCacheHeader));
+    m_sampleCount = static_cast<size_t>(header->sampleCount);
+    m_sampleRate = static_cast<int>(header->sampleRate);
+    m_channelCount = static_cast<int>(header->channelCount);
+
+    return true;
+}
+
+void PcmCache::close() {
+    if (m_mapping) {
+        munmap(m_mapping, m_mappingSize);
+        m_mapping = nullptr;
+    }
+
+    m_mappingSize = 0;
+    m_samples = nullptr;
+    m_sampleCount = 0;
+    m_sampleRate = 0;
+    m_channelCount = 0;
+}
+
+bool PcmCache::store(
+    const std::string& sourcePath,
+    const float* samples,
+    size_t sampleCount,
+    int sampleRate,
+    int channelCount
+) {
+    // Entries that could not be mapped or would not fit the cache at all
+    // are not worth writing
+    if (sampleCount > (SIZE_MAX - sizeof(PcmCacheHeader)) / sizeof(float)
+        || sizeof(PcmCacheHeader) + sampleCount * sizeof(float) > kMaxCacheBytes) {
+        return false;
+    }
+
+    std::string cachePath = getCachePath(sourcePath);
+    if (cachePath.empty()) {
+        return false;
+    }
+
+    PcmCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kPcmCacheMagic, sizeof(kPcmCacheMagic));
+    header.version = kPcmCacheVersion;
+    header.sampleRate = static_cast<uint32_t>(sampleRate);
+    header.channelCount = static_cast<uint32_t>(channelCount);
+    header.sampleFormat = kSampleFormatFloat32;
+    header.sampleCount = sampleCount;
+    header.pathHash = hashPath(canonicalPath(sourcePath));
+
+    if (!statSource(sourcePath, header.sourceSize, header.sourceMtime)) {
+        return false;
+    }
+
+    // Write to a temporary file and rename it so readers never see a partial entry
+    std::string tempPath = cachePath + ".tmp." + std::to_string(getpid());
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create PCM cache file: " << tempPath << std::endl;
+        return false;
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(samples, sizeof(float), sampleCount, file) == sampleCount;
+
+    if (fclose(file) != 0) {
+        written = false;
+    }
+
+    if (!written || rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        std::cerr << "Failed to write PCM cache file: " << cachePath << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+
+    evictEntries(std::filesystem::path(cachePath).parent_path().string(), cachePath, kMaxCacheBytes);
+
+    return true;
+}
+
+const float* PcmCache::getSamples() const {
+    return m_samples;
+}
+
+size_t PcmCache::getSampleCount() const {
+    return m_sampleCount;
+}
+
+int PcmCache::getSampleRate() const {
+    return m_sampleRate;
+}
+
+int PcmCache::getChannelCount() const {
+    return m_channelCount;
+}
+
+std::string PcmCache::getCachePath(const std::string& sourcePath) {
+    std::string directory = getCacheDirectory();
+    if (directory.empty()) {
+        return "";
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx%s",
+             static_cast<unsigned long long>(hashPath(canonicalPath(sourcePath))), kPcmCacheExtension);
+
+    return (std::filesystem::path(directory) / name).string();
+}
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <cstring>
+#include "audio/sample_ring.h"
+
+static size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+SampleRing::SampleRing(size_t capacity)
+    : m_buffer(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2)), 0.0f)
+    , m_mask(m_buffer.size() - 1)
+    , m_writePosition(0)
+    , m_readPosition(0)
+    , m_overrunCount(0)
+    , m_underrunCount(0)
+{
+}
+
+SampleRing::~SampleRing() {
+}
+
+size_t SampleRing::write(const float* samples, size_t count) {
+    const uint64_t writePos = m_writePosition.load(std::memory_order_relaxed);
+    const uint64_t readPos = m_readPosition.load(std::memory_order_acquire);
+
+    // Never overwrite samples the consumer has not read yet, and never split
+    // a block so the consumer always sees whole interleaved frames
+    size_t freeSpace = m_buffer.size() - static_cast<size_t>(writePos - readPos);
+    if (count > freeSpace) {
+        m_overrunCount.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    const size_t toWrite = count;
+
+    // Copy in at most two pieces around the wrap point
+    size_t start = static_cast<size_t>(writePos) & m_mask;
+    size_t firstPart = std::min(toWrite, m_buffer.size() - start);
+    memcpy(m_buffer.data() + start, samples, firstPart * sizeof(float));
+    if (firstPart < toWrite) {
+        memcpy(m_buffer.data(), samples + firstPart, (toWrite - firstPart) * sizeof(float));
+    }
+
+    // Publish the new samples to the consumer
+    m_writePosition.store(writePos + toWrite, std::memory_order_release);
+
+    return toWrite;
+}
+
+size_t SampleRing::getWriteAvailable() const {
+    const uint64_t writePos = m_writePosition.load(std::memory_order_relaxed);
+    const uint64_t readPos = m_readPosition.load(std::memory_order_acquire);
+    return m_buffer.size() - static_cast<size_t>(writePos - readPos);
+}
+
+size_t SampleRing::read(float* dest, size_t count) {
+    const uint64_t readPos = m_readPosition.load(std::memory_order_relaxed);
+    const uint64_t writePos = m_writePosition.load(std::memory_order_acquire);
+
+    size_t available = static_cast<size_t>(writePos - readPos);
+    size_t toRead = std::min(count, available);
+    if (toRead < count) {
+        m_underrunCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (toRead == 0) {
+        return 0;
+    }
+
+    copyOut(readPos, dest, toRead);
+
+    // Hand the slots back to the producer
+    m_readPosition.store(readPos + toRead, std::memory_order_release);
+
+    return toRead;
+}
+
+size_t SampleRing::readLatest(float* dest, size_t count) {
+    const uint64_t writePos = m_writePosition.load(std::memory_order_acquire);
+
+    // Samples published after writePos was loaded stay unread for next time
+    size_t toRead = peekLatest(dest, count);
+
+    // Skip everything up to the write position
+    m_readPosition.store(writePos, std::memory_order_release);
+
+    return toRead;
+}
+
+size_t SampleRing::peekLatest(float* dest, size_t count) {
+    const uint64_t writePos = m_writePosition.load(std::memory_order_acquire);
+
+    // The newest samples are still valid even if they were already consumed,
+    // as long as the producer cannot have wrapped onto them
+    size_t toRead = static_cast<size_t>(std::min<uint64_t>(count, writePos));
+    toRead = std::min(toRead, m_buffer.size() / 2);
+    if (toRead < count) {
+        m_underrunCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (toRead > 0) {
+        copyOut(writePos - toRead, dest, toRead);
+    }
+
+    return toRead;
+}
+
+size_t SampleRing::getReadAvailable() const {
+    const uint64_t readPos = m_readPosition.load(std::memory_order_relaxed);
+    const uint64_t writePos = m_writePosition.load(std::memory_order_acquire);
+    return static_cast<size_t>(writePos - readPos);
+}
+
+uint64_t SampleRing::getWritePosition() const {
+    return m_writePosition.load(std::memory_order_acquire);
+}
+
+uint64_t SampleRing::getReadPosition() const {
+    return m_readPosition.load(std::memory_order_acquire);
+}
+
+size_t SampleRing::getCapacity() const {
+    return m_buffer.size();
+}
+
+uint64_t SampleRing::getOverrunCount() const {
+    return m_overrunCount.load(std::memory_order_relaxed);
+}
+
+uint64_t SampleRing::getUnderrunCount() const {
+    return m_underrunCount.load(std::memory_order_relaxed);
+}
+
+void SampleRing::reset() {
+    m_writePosition.store(0, std::memory_order_relaxed);
+    m_readPosition.store(0, std::memory_order_relaxed);
+    m_overrunCount.store(0, std::memory_order_relaxed);
+    m_underrunCount.store(0, std::memory_order_relaxed);
+    std::fill(m_buffer.begin(), m_buffer.end(), 0.0f);
+}
+
+void SampleRing::copyOut(uint64_t position, float* dest, size_t count) const {
+    size_t start = static_cast<size_t>(position) & m_mask;
+    size_t firstPart = std::min(count, m_buffer.size() - start);
+    memcpy(dest, m_buffer.data() + start, firstPart * sizeof(float));
+    if (firstPart < count) {
+        memcpy(dest + firstPart, m_buffer.data(), (count - firstPart) * sizeof(float));
+    }
+}
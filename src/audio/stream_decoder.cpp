@@ -0,0 +1,182 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "audio/stream_decoder.h"
+#include "audio/sample_ring.h"
+
+// How long the reader sleeps when the prefetch queue is full
+static const std::chrono::milliseconds kReaderPollInterval(5);
+
+StreamDecoder::StreamDecoder()
+    : m_chunkFrames(0)
+    , m_sampleRate(44100)
+    , m_channelCount(2)
+    , m_frameCount(0)
+    , m_running(false)
+    , m_endOfFile(false)
+{
+#ifdef USE_LIBSNDFILE
+    m_file = nullptr;
+#endif
+}
+
+StreamDecoder::~StreamDecoder() {
+    close();
+}
+
+bool StreamDecoder::open(const std::string& filePath, size_t chunkFrames, size_t prefetchChunks) {
+    close();
+
+#ifdef USE_LIBSNDFILE
+    SF_INFO sfInfo;
+    memset(&sfInfo, 0, sizeof(sfInfo));
+
+    m_file = sf_open(filePath.c_str(), SFM_READ, &sfInfo);
+    if (!m_file) {
+        std::cerr << "Error opening sound file: " << sf_strerror(NULL) << std::endl;
+        return false;
+    }
+
+    m_sampleRate = sfInfo.samplerate;
+    m_channelCount = sfInfo.channels;
+    m_frameCount = sfInfo.frames;
+    m_chunkFrames = chunkFrames;
+
+    // Memory is bounded by the prefetch depth, not by the track length
+    m_chunk.resize(m_chunkFrames * m_channelCount);
+    m_ring = std::make_unique<SampleRing>(m_chunkFrames * m_channelCount * prefetchChunks);
+    m_endOfFile = false;
+
+    // Decode the first chunk synchronously so playback can start right away
+    if (!decodeChunk()) {
+        m_endOfFile = true;
+    }
+
+    startReader();
+
+    std::cout << "Streaming audio file: " << filePath << std::endl;
+    std::cout << "Sample rate: " << m_sampleRate << ", Channels: " << m_channelCount << std::endl;
+    std::cout << "Duration: " << float(m_frameCount) / m_sampleRate << " seconds, prefetch: "
+              << m_ring->getCapacity() * sizeof(float) / 1024 << " KB" << std::endl;
+
+    return true;
+#else
+    std::cerr << "Streaming requires libsndfile: " << filePath << std::endl;
+    return false;
+#endif
+}
+
+void StreamDecoder::close() {
+    stopReader();
+
+#ifdef USE_LIBSNDFILE
+    if (m_file) {
+        sf_close(m_file);
+        m_file = nullptr;
+    }
+#endif
+
+    m_ring.reset();
+    m_chunk.clear();
+    m_chunk.shrink_to_fit();
+    m_endOfFile = false;
+}
+
+size_t StreamDecoder::readSamples(float* dest, size_t numSamples) {
+    if (!m_ring) {
+        return 0;
+    }
+
+    return m_ring->read(dest, numSamples);
+}
+
+bool StreamDecoder::rewind() {
+#ifdef USE_LIBSNDFILE
+    if (!m_file) {
+        return false;
+    }
+
+    stopReader();
+
+    if (sf_seek(m_file, 0, SEEK_SET) < 0) {
+        std::cerr << "Error seeking sound file: " << sf_strerror(m_file) << std::endl;
+        return false;
+    }
+
+    m_ring->reset();
+    m_endOfFile = !decodeChunk();
+
+    startReader();
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool StreamDecoder::isFinished() const {
+    return m_endOfFile && (!m_ring || m_ring->getReadAvailable() == 0);
+}
+
+int StreamDecoder::getSampleRate() const {
+    return m_sampleRate;
+}
+
+int StreamDecoder::getChannelCount() const {
+    return m_channelCount;
+}
+
+int64_t StreamDecoder::getFrameCount() const {
+    return m_frameCount;
+}
+
+void StreamDecoder::readerLoop() {
+    while (m_running && !m_endOfFile) {
+        // Only decode when a whole chunk fits, the ring never drops samples here
+        if (m_ring->getWriteAvailable() >= m_chunk.size()) {
+            if (!decodeChunk()) {
+                m_endOfFile = true;
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wakeCondition.wait_for(lock, kReaderPollInterval, [this] { return !m_running; });
+    }
+}
+
+bool StreamDecoder::decodeChunk() {
+#ifdef USE_LIBSNDFILE
+    sf_count_t frames = sf_readf_float(m_file, m_chunk.data(), m_chunkFrames);
+    if (frames <= 0) {
+        return false;
+    }
+
+    m_ring->write(m_chunk.data(), static_cast<size_t>(frames) * m_channelCount);
+
+    return static_cast<size_t>(frames) == m_chunkFrames;
+#else
+    return false;
+#endif
+}
+
+void StreamDecoder::startReader() {
+    if (m_endOfFile) {
+        return;
+    }
+
+    m_running = true;
+    m_readerThread = std::thread(&StreamDecoder::readerLoop, this);
+}
+
+void StreamDecoder::stopReader() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_running = false;
+    }
+    m_wakeCondition.notify_all();
+
+    if (m_readerThread.joinable()) {
+        m_readerThread.join();
+    }
+}
@@ -44,7 +44,7 @@ void InputHandler::update() {
     // Check for key presses (we'll only check keys we're actually using)
     // This is more efficient than checking all possible keys
     const int keysToCheck[] = {
-        GLFW_KEY_ESCAPE, GLFW_KEY_SPACE, GLFW_KEY_P,
+        GLFW_KEY_ESCAPE, GLFW_KEY_SPACE, GLFW_KEY_P, GLFW_KEY_B,
         GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D,
         GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_LEFT, GLFW_KEY_RIGHT,
         GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3
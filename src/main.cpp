@@ -6,6 +6,11 @@
 #include <GLFW/glfw3.h>
 #include <memory>
 #include <GLFW/glfw3.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
 
 #include "audio/audio_manager.h"
 #include <GLFW/glfw3.h>
@@ -13,15 +18,68 @@
 #include <GLFW/glfw3.h>
 #include "analysis/beat_detector.h"
 #include <GLFW/glfw3.h>
+#include "analysis/filterbank.h"
+#include "analysis/feature_extractor.h"
+#include "analysis/constant_q_analyzer.h"
+#include "analysis/multichannel_analyzer.h"
+#include "analysis/offline_analyzer.h"
+#include "analysis/analysis_thread.h"
 #include "visualization/visualization_manager.h"
 #include <GLFW/glfw3.h>
 #include "render/render_engine.h"
 #include <GLFW/glfw3.h>
 #include "input/input_handler.h"
+#include "util/thread_pool.h"
+#include "util/pcg_random.h"
 #include <GLFW/glfw3.h>
 
 int main(int argc, char* argv[]) {
     try {
+        // Parse command line: [--stream] [--multires] [--channels <n>] [--seed <n>] [--particles <n>] [audio_file] | --analyze <file> [--output <path>]
+        std::string audioFile;
+        std::string analyzeFile;
+        std::string outputFile;
+        bool streamAudio = false;
+        bool multiResolution = false;
+        int inputChannels = 2;
+        uint64_t seed = PcgRandom::randomSeed();
+        int maxParticles = 800;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--stream") {
+                streamAudio = true;
+            } else if (arg == "--multires") {
+                multiResolution = true;
+            } else if (arg == "--channels" && i + 1 < argc) {
+                inputChannels = std::atoi(argv[++i]);
+            } else if (arg == "--seed" && i + 1 < argc) {
+                seed = std::strtoull(argv[++i], nullptr, 10);
+            } else if (arg == "--particles" && i + 1 < argc) {
+                maxParticles = std::atoi(argv[++i]);
+            } else if (arg == "--analyze" && i + 1 < argc) {
+                analyzeFile = argv[++i];
+            } else if (arg == "--output" && i + 1 < argc) {
+                outputFile = argv[++i];
+            } else {
+                audioFile = arg;
+            }
+        }
+        
+        // Headless offline analysis, no window or audio device needed
+        if (!analyzeFile.empty()) {
+            if (outputFile.empty()) {
+                outputFile = analyzeFile + ".analysis.csv";
+            }
+            
+            OfflineAnalyzer offlineAnalyzer;
+            if (!offlineAnalyzer.initialize(2048, 256, 0.25f)) {
+                std::cerr << "Failed to initialize offline analyzer" << std::endl;
+                return 1;
+            }
+            
+            return offlineAnalyzer.analyzeFile(analyzeFile, outputFile) ? 0 : 1;
+        }
+        
         std::cout << "Initializing Music Visualizer..." << std::endl;
 
         // Initialize rendering system
@@ -47,7 +105,7 @@ int main(int argc, char* argv[]) {
 
         // Initialize audio analysis
         auto fftAnalyzer = std::make_shared<FFTAnalyzer>();
-        if (!fftAnalyzer->initialize(2048)) { // 2048 sample window size
+        if (!fftAnalyzer->initialize(2048, 256)) { // 2048 sample window, 256 sample hop
             std::cerr << "Failed to initialize FFT analyzer" << std::endl;
             return 1;
         }
@@ -58,32 +116,134 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
+        // Persistent workers for the particle simulation, one per hardware
+        // thread left after the render and analysis threads. Separate from
+        // the channel analysis pool, which the analysis thread drives.
+        int simulationWorkers = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 2);
+        auto simulationPool = std::make_shared<ThreadPool>();
+        if (!simulationPool->start(simulationWorkers)) {
+            std::cerr << "Failed to start simulation workers" << std::endl;
+            return 1;
+        }
+
         // Initialize visualization system
-        auto visualizationManager = std::make_shared<VisualizationManager>(renderEngine);
+        // Printed so a run can be replayed with --seed
+        std::cout << "Visualization seed: " << seed << std::endl;
+        auto visualizationManager = std::make_shared<VisualizationManager>(renderEngine, simulationPool, seed, maxParticles);
         if (!visualizationManager->initialize()) {
             std::cerr << "Failed to initialize visualization manager" << std::endl;
             return 1;
         }
 
-        // Load audio if specified in command arguments
-        if (argc > 1) {
-            if (!audioManager->loadFile(argv[1])) {
-                std::cerr << "Failed to load audio file: " << argv[1] << std::endl;
+        // Load audio if specified in command arguments, otherwise open the
+        // input. Either gives the sample rate and channel count the analyzers
+        // below are built for; nothing plays until they are all ready.
+        if (!audioFile.empty()) {
+            if (!audioManager->loadFile(audioFile, streamAudio)) {
+                std::cerr << "Failed to load audio file: " << audioFile << std::endl;
                 return 1;
             }
-            audioManager->play();
         } else {
-            if (!audioManager->startInputCapture()) {
-                std::cerr << "Failed to start audio input capture" << std::endl;
+            if (!audioManager->openInputCapture(inputChannels)) {
+                std::cerr << "Failed to open audio input capture" << std::endl;
+                return 1;
+            }
+        }
+
+        // Group the FFT bins into log-spaced bands for the visualizers, once the
+        // sample rate of the source is known
+        auto filterbank = std::make_shared<Filterbank>();
+        if (!filterbank->initialize(audioManager->getSampleRate(), fftAnalyzer->getWindowSize(), 64)) {
+            std::cerr << "Failed to initialize filterbank" << std::endl;
+            return 1;
+        }
+
+        // Optional multi-resolution bands: a 2048 window at 1/8 rate for the
+        // bass (about 2.7 Hz bins at 44.1 kHz) and a 512 window for the highs
+        if (multiResolution && !fftAnalyzer->enableMultiResolution(
+                audioManager->getSampleRate(), 8, 2048, 512, filterbank->getBandCount())) {
+            std::cerr << "Failed to enable multi-resolution analysis" << std::endl;
+            return 1;
+        }
+
+        // Per-frame spectral and temporal features for the visualizers
+        auto featureExtractor = std::make_shared<FeatureExtractor>();
+        if (!featureExtractor->initialize(audioManager->getSampleRate(), fftAnalyzer->getWindowSize())) {
+            std::cerr << "Failed to initialize feature extractor" << std::endl;
+            return 1;
+        }
+
+        // Semitone spectrum and chroma from C2 up, refreshed every 2048 samples
+        auto constantQAnalyzer = std::make_shared<ConstantQAnalyzer>();
+        if (!constantQAnalyzer->initialize(audioManager->getSampleRate(), 2048)) {
+            std::cerr << "Failed to initialize constant-Q analyzer" << std::endl;
+            return 1;
+        }
+
+        // Multichannel sources also get a spectrum per channel and, for the
+        // front pair, mid/side and correlation per band. The channels are
+        // spread over a few workers so 8 channels cost little more than 2.
+        // Wider sources are still played and analyzed as a downmix.
+        std::shared_ptr<MultichannelAnalyzer> multichannelAnalyzer;
+        int channelCount = audioManager->getChannelCount();
+        if (channelCount > MultichannelAnalyzer::getMaxChannels()) {
+            std::cout << "Per-channel analysis supports up to " << MultichannelAnalyzer::getMaxChannels()
+                      << " channels, analyzing the " << channelCount << "-channel source as a downmix only"
+                      << std::endl;
+        } else if (channelCount >= 2) {
+            int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+            int workers = std::max(0, std::min(channelCount, hardwareThreads / 2) - 1);
+            auto channelPool = std::make_shared<ThreadPool>();
+            if (!channelPool->start(workers)) {
+                std::cerr << "Failed to start channel analysis workers" << std::endl;
                 return 1;
             }
+            
+            multichannelAnalyzer = std::make_shared<MultichannelAnalyzer>();
+            if (!multichannelAnalyzer->initialize(audioManager->getChannelLayout(), audioManager->getSampleRate(),
+                    fftAnalyzer->getWindowSize(), fftAnalyzer->getHopSize(), filterbank->getBandCount(), channelPool)) {
+                std::cerr << "Failed to initialize multichannel analysis, continuing without it" << std::endl;
+                multichannelAnalyzer.reset();
+            }
+        }
+
+        // Spectral-flux onsets run on the same hops as the FFT analyzer
+        if (!beatDetector->initializeOnsetDetection(
+                audioManager->getSampleRate(), fftAnalyzer->getWindowSize(), fftAnalyzer->getHopSize())) {
+            std::cerr << "Failed to initialize onset detection" << std::endl;
+            return 1;
         }
+        
+        // Predicted beats are announced early by one audio buffer plus one
+        // rendered frame, so visuals land on the beat rather than after it
+        beatDetector->setPredictionLookahead(
+            static_cast<float>(audioManager->getBufferSize()) / audioManager->getSampleRate() + 1.0f / 60.0f);
 
         std::cout << "Music Visualizer initialized successfully" << std::endl;
-        std::cout << "Press ESC to exit, SPACE to switch visualizer" << std::endl;
+        std::cout << "Press ESC to exit, SPACE to switch visualizer, B to switch beat detection" << std::endl;
 
+        // Analysis runs on its own thread from here on, the render loop only
+        // reads the frames it publishes
+        auto analysisThread = std::make_shared<AnalysisThread>(
+            audioManager, fftAnalyzer, beatDetector, filterbank, featureExtractor, constantQAnalyzer,
+            multichannelAnalyzer);
+        
+        // Start the audio only now: planning the analyzers' FFTs can take a
+        // while on a cold start, and the audio would run ahead of the
+        // analysis and the frozen window meanwhile
+        if (!audioManager->play()) {
+            std::cerr << "Failed to start audio" << std::endl;
+            return 1;
+        }
+        if (!analysisThread->start()) {
+            std::cerr << "Failed to start analysis thread" << std::endl;
+            return 1;
+        }
+        
         // Main loop
         auto lastTime = std::chrono::high_resolution_clock::now();
+        float titleTimer = 0.0f;
+        int titleFrames = 0;
         while (!renderEngine->shouldClose()) {
             // Calculate delta time
             auto currentTime = std::chrono::high_resolution_clock::now();
@@ -102,23 +262,29 @@ int main(int argc, char* argv[]) {
             if (inputHandler->isKeyPressed(GLFW_KEY_P) && inputHandler->isKeyJustPressed()) {
                 audioManager->togglePlayback();
             }
+            
+            // Handle input for switching the beat detection algorithm
+            if (inputHandler->isKeyPressed(GLFW_KEY_B) && inputHandler->isKeyJustPressed()) {
+                switch (analysisThread->getBeatAlgorithm()) {
+                    case BeatAlgorithm::Energy:
+                        analysisThread->setBeatAlgorithm(BeatAlgorithm::SpectralFlux);
+                        break;
+                    case BeatAlgorithm::SpectralFlux:
+                        analysisThread->setBeatAlgorithm(BeatAlgorithm::Predicted);
+                        break;
+                    default:
+                        analysisThread->setBeatAlgorithm(BeatAlgorithm::Energy);
+                        break;
+                }
+            }
 
-            // Get audio data
-            std::vector<float> audioSamples = audioManager->getAudioSamples();
+            // Pick up the newest analysis frame without waiting for one
+            analysisThread->acquireFrame();
+            const AnalysisFrame& frame = analysisThread->getFrame();
             
-            // Process audio data
-            if (!audioSamples.empty()) {
-                // Analyze audio data
-                fftAnalyzer->processAudioData(audioSamples);
-                beatDetector->analyzeAudio(audioSamples);
-                
-                // Update visualization
-                visualizationManager->update(
-                    deltaTime,
-                    audioSamples,
-                    fftAnalyzer->getSpectrumData(),
-                    beatDetector->isBeatDetected()
-                );
+            // Update visualization
+            if (!frame.samples.empty()) {
+                visualizationManager->update(deltaTime, frame);
             }
 
             // Render frame
@@ -126,11 +292,26 @@ int main(int argc, char* argv[]) {
             visualizationManager->render();
             renderEngine->endFrame();
 
+            // Show frame rate and renderer counters in the title once a second
+            titleTimer += deltaTime;
+            titleFrames++;
+            if (titleTimer >= 1.0f) {
+                const RenderStats& stats = renderEngine->getFrameStats();
+                std::ostringstream title;
+                title << "Music Visualizer - " << static_cast<int>(titleFrames / titleTimer + 0.5f) << " fps, "
+                      << stats.drawCalls << " draws, " << stats.vertices << " vertices, " << stats.circles << " circles, "
+                      << (stats.bytesUploaded + 512) / 1024 << " KB uploaded";
+                renderEngine->setTitle(title.str());
+                titleTimer = 0.0f;
+                titleFrames = 0;
+            }
+
             // Limit frame rate
             std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
 
         // Cleanup
+        analysisThread->stop();
         audioManager->shutdown();
         visualizationManager->shutdown();
         renderEngine->shutdown();
@@ -1,11 +1,29 @@
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <algorithm>
+#include <cstddef>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include "render/render_engine.h"
 #include "render/shader_manager.h"
 
+// Floats per vertex: position (x, y) and color (r, g, b, a)
+static const int kFloatsPerVertex = 6;
+
+// Vertices batched before a flush is forced mid-frame (1.5 MB)
+static const int kMaxBatchVertices = 65536;
+
+// Circle instances batched before a flush is forced mid-frame (4 MB)
+static const int kMaxBatchCircles = 262144;
+
+// Initial size of the VBOs' storage; they grow to the largest batch seen
+static const size_t kInitialBufferBytes = 256 * 1024;
+
+// Segments of the shared unit-circle mesh. Fine enough for the largest
+// particles, and the vertex shader cost is negligible for small ones.
+static const int kCircleMeshSegments = 24;
+
 // Callback function for GLFW errors
 static void glfwErrorCallback(int error, const char* description) {
     std::cerr << "GLFW Error " << error << ": " << description << std::endl;
@@ -24,6 +42,13 @@ RenderEngine::RenderEngine()
     , m_vao(0)
     , m_vbo(0)
     , m_currentShader(0)
+    , m_vboCapacity(0)
+    , m_circleShader(0)
+    , m_circleVao(0)
+    , m_circleMeshVbo(0)
+    , m_circleInstanceVbo(0)
+    , m_circleInstanceCapacity(0)
+    , m_unitCircleSegments(0)
 {
 }
 
@@ -85,19 +110,17 @@ bool RenderEngine::initialize(int width, int height, const std::string& title) {
     // Set up VAO
     glBindVertexArray(m_vao);
     
-    // Configure VBO - we need to actually allocate some initial data
+    // Configure VBO with storage for the batches; it is rewritten every flush
     glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    
-    // Allocate initial buffer data (empty for now, will be updated in draw calls)
-    float initialData[36] = {0}; // 6 vertices * 6 components (pos + color)
-    glBufferData(GL_ARRAY_BUFFER, sizeof(initialData), initialData, GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, kInitialBufferBytes, nullptr, GL_STREAM_DRAW);
+    m_vboCapacity = kInitialBufferBytes;
     
     // Position attribute (x, y)
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, kFloatsPerVertex * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     
     // Color attribute (r, g, b, a)
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, kFloatsPerVertex * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
     
     // Unbind
@@ -110,6 +133,12 @@ bool RenderEngine::initialize(int width, int height, const std::string& title) {
         std::cerr << "OpenGL error after VAO/VBO setup: " << error << std::endl;
     }
     
+    // Vertex arena, reused every frame
+    m_vertices.reserve(static_cast<size_t>(kMaxBatchVertices) * kFloatsPerVertex);
+    
+    // Unit-circle mesh and instance buffer for instanced circles
+    createCircleMesh();
+    
     std::cout << "Render engine initialized: " << width << "x" << height << std::endl;
     
     return true;
@@ -127,6 +156,25 @@ void RenderEngine::shutdown() {
         glDeleteBuffers(1, &m_vbo);
         m_vbo = 0;
     }
+    m_vboCapacity = 0;
+    m_vertices.clear();
+    
+    if (m_circleVao) {
+        glDeleteVertexArrays(1, &m_circleVao);
+        m_circleVao = 0;
+    }
+    
+    if (m_circleMeshVbo) {
+        glDeleteBuffers(1, &m_circleMeshVbo);
+        m_circleMeshVbo = 0;
+    }
+    
+    if (m_circleInstanceVbo) {
+        glDeleteBuffers(1, &m_circleInstanceVbo);
+        m_circleInstanceVbo = 0;
+    }
+    m_circleInstanceCapacity = 0;
+    m_circles.clear();
     
     m_shaderManager.reset();
     
@@ -199,8 +247,45 @@ bool RenderEngine::createShaders() {
     
     m_currentShader = shader;
     
-    // Set projection matrix
-    glUseProgram(m_shaderManager->getShaderProgram(m_currentShader));
+    // Instanced circles: the unit mesh is scaled and moved per instance
+    const char* circleVertexShaderSource = R"(
+        #version 330 core
+        layout (location = 0) in vec2 aUnit;
+        layout (location = 1) in vec3 aCircle;
+        layout (location = 2) in vec4 aColor;
+        
+        out vec4 vertexColor;
+        
+        uniform mat4 projection;
+        
+        void main() {
+            gl_Position = projection * vec4(aCircle.xy + aUnit * aCircle.z, 0.0, 1.0);
+            vertexColor = aColor;
+        }
+    )";
+    
+    m_circleShader = m_shaderManager->createShaderProgram(circleVertexShaderSource, fragmentShaderSource);
+    if (!m_circleShader) {
+        std::cerr << "Failed to create instanced circle shader" << std::endl;
+        return false;
+    }
+    
+    setProjection(m_shaderManager->getShaderProgram(m_currentShader));
+    setProjection(m_shaderManager->getShaderProgram(m_circleShader));
+    
+    // Check for errors
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        std::cerr << "OpenGL error after setting projection matrix: " << error << std::endl;
+    }
+    
+    std::cout << "Shaders created successfully" << std::endl;
+    
+    return true;
+}
+
+void RenderEngine::setProjection(unsigned int program) {
+    glUseProgram(program);
     
     // Create orthographic projection matrix
     float left = 0.0f;
@@ -217,22 +302,55 @@ bool RenderEngine::createShaders() {
         -(right + left) / (right - left), -(top + bottom) / (top - bottom), -(zFar + zNear) / (zFar - zNear), 1.0f
     };
     
-    int projectionLoc = glGetUniformLocation(m_shaderManager->getShaderProgram(m_currentShader), "projection");
+    int projectionLoc = glGetUniformLocation(program, "projection");
     if (projectionLoc == -1) {
         std::cerr << "Could not find projection uniform in shader" << std::endl;
     } else {
         glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, orthoMatrix);
     }
-    
-    // Check for errors
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        std::cerr << "OpenGL error after setting projection matrix: " << error << std::endl;
+}
+
+void RenderEngine::createCircleMesh() {
+    // Triangle fan: centre, then the rim closed back on its first point
+    std::vector<float> mesh;
+    mesh.reserve((kCircleMeshSegments + 2) * 2);
+    mesh.push_back(0.0f);
+    mesh.push_back(0.0f);
+    const float* unit = getUnitCircle(kCircleMeshSegments);
+    for (int i = 0; i <= kCircleMeshSegments; ++i) {
+        mesh.push_back(unit[i * 2]);
+        mesh.push_back(unit[i * 2 + 1]);
     }
     
-    std::cout << "Shaders created successfully" << std::endl;
+    glGenVertexArrays(1, &m_circleVao);
+    glGenBuffers(1, &m_circleMeshVbo);
+    glGenBuffers(1, &m_circleInstanceVbo);
     
-    return true;
+    glBindVertexArray(m_circleVao);
+    
+    // Mesh vertices, uploaded once
+    glBindBuffer(GL_ARRAY_BUFFER, m_circleMeshVbo);
+    glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(float), mesh.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    
+    // Per-instance centre and radius, then colour as normalized bytes
+    glBindBuffer(GL_ARRAY_BUFFER, m_circleInstanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, kInitialBufferBytes, nullptr, GL_STREAM_DRAW);
+    m_circleInstanceCapacity = kInitialBufferBytes;
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(CircleInstance),
+                          (void*)offsetof(CircleInstance, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CircleInstance),
+                          (void*)offsetof(CircleInstance, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    
+    m_circles.reserve(kMaxBatchCircles);
 }
 
 void RenderEngine::beginFrame() {
@@ -243,6 +361,11 @@ void RenderEngine::beginFrame() {
 }
 
 void RenderEngine::endFrame() {
+    // Draw whatever the frame batched
+    flush();
+    m_frameStats = m_stats;
+    m_stats = RenderStats();
+    
     // Swap buffers
     glfwSwapBuffers(m_window);
     
@@ -251,6 +374,81 @@ void RenderEngine::endFrame() {
     // std::cout << "Frame ended" << std::endl;
 }
 
+void RenderEngine::flush() {
+    // At most one of the two holds anything
+    flushVertices();
+    flushCircles();
+}
+
+void RenderEngine::orphanBuffer(size_t bytes, size_t& capacity) {
+    // Orphan the storage before writing so the driver can hand out fresh
+    // memory instead of waiting for the GPU to finish the previous batch
+    if (bytes > capacity) {
+        capacity = std::max(bytes, capacity * 2);
+    }
+    glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+}
+
+void RenderEngine::flushVertices() {
+    if (m_vertices.empty()) {
+        return;
+    }
+    
+    const int vertexCount = static_cast<int>(m_vertices.size() / kFloatsPerVertex);
+    const size_t bytes = m_vertices.size() * sizeof(float);
+    
+    glUseProgram(m_shaderManager->getShaderProgram(m_currentShader));
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    
+    orphanBuffer(bytes, m_vboCapacity);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_vertices.data());
+    
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    
+    m_stats.drawCalls++;
+    m_stats.vertices += vertexCount;
+    m_stats.bytesUploaded += bytes;
+    m_vertices.clear();
+}
+
+void RenderEngine::flushCircles() {
+    if (m_circles.empty()) {
+        return;
+    }
+    
+    const int circleCount = static_cast<int>(m_circles.size());
+    const size_t bytes = m_circles.size() * sizeof(CircleInstance);
+    
+    glUseProgram(m_shaderManager->getShaderProgram(m_circleShader));
+    glBindVertexArray(m_circleVao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_circleInstanceVbo);
+    
+    orphanBuffer(bytes, m_circleInstanceCapacity);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_circles.data());
+    
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, kCircleMeshSegments + 2, circleCount);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    
+    m_stats.drawCalls++;
+    m_stats.circles += circleCount;
+    m_stats.bytesUploaded += bytes;
+    m_circles.clear();
+}
+
+const RenderStats& RenderEngine::getFrameStats() const {
+    return m_frameStats;
+}
+
+void RenderEngine::setTitle(const std::string& title) {
+    glfwSetWindowTitle(m_window, title.c_str());
+}
+
 bool RenderEngine::shouldClose() const {
     return glfwWindowShouldClose(m_window);
 }
@@ -264,54 +462,61 @@ void RenderEngine::getViewportSize(int& width, int& height) const {
     height = m_height;
 }
 
+float* RenderEngine::appendVertices(int count) {
+    // Circles submitted before this must be drawn first
+    flushCircles();
+    
+    // Keep batches bounded: a frame that outgrows the arena draws in pieces
+    const size_t used = m_vertices.size();
+    if (used / kFloatsPerVertex + count > static_cast<size_t>(kMaxBatchVertices) && used > 0) {
+        flush();
+    }
+    
+    const size_t offset = m_vertices.size();
+    m_vertices.resize(offset + static_cast<size_t>(count) * kFloatsPerVertex);
+    return m_vertices.data() + offset;
+}
+
+float* RenderEngine::writeVertex(float* out, float x, float y, float r, float g, float b, float a) {
+    out[0] = x;
+    out[1] = y;
+    out[2] = r;
+    out[3] = g;
+    out[4] = b;
+    out[5] = a;
+    return out + kFloatsPerVertex;
+}
+
+const float* RenderEngine::getUnitCircle(int segments) {
+    // Visualizers draw many circles with the same segment count in a row
+    if (segments != m_unitCircleSegments) {
+        m_unitCircle.resize((segments + 1) * 2);
+        for (int i = 0; i < segments; ++i) {
+            float angle = 2.0f * M_PI * i / segments;
+            m_unitCircle[i * 2] = std::cos(angle);
+            m_unitCircle[i * 2 + 1] = std::sin(angle);
+        }
+        // Close the circle exactly
+        m_unitCircle[segments * 2] = m_unitCircle[0];
+        m_unitCircle[segments * 2 + 1] = m_unitCircle[1];
+        m_unitCircleSegments = segments;
+    }
+    return m_unitCircle.data();
+}
+
 void RenderEngine::drawRectangle(
     float x, float y, float width, float height,
     float r, float g, float b, float a
 ) {
-    // Vertices for a rectangle (2 triangles)
-    float vertices[] = {
-        // Positions (x, y)        // Colors (r, g, b, a)
-        x, y,                      r, g, b, a,
-        x + width, y,              r, g, b, a,
-        x + width, y + height,     r, g, b, a,
-        
-        x, y,                      r, g, b, a,
-        x + width, y + height,     r, g, b, a,
-        x, y + height,             r, g, b, a
-    };
-    
-    // Bind shader
-    glUseProgram(m_shaderManager->getShaderProgram(m_currentShader));
-    
-    // Bind VAO
-    glBindVertexArray(m_vao);
-    
-    // Update VBO data
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-    
-    // Make sure attributes are enabled
-    glEnableVertexAttribArray(0); // Position
-    glEnableVertexAttribArray(1); // Color
-    
-    // Check for errors after buffer data
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        std::cerr << "OpenGL error after buffer data: " << error << std::endl;
-    }
-    
-    // Draw
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    // Check for errors after draw
-    error = glGetError();
-    if (error != GL_NO_ERROR) {
-        std::cerr << "OpenGL error after draw: " << error << std::endl;
-    }
-    
-    // Unbind
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    // Two triangles
+    float* out = appendVertices(6);
+    out = writeVertex(out, x, y, r, g, b, a);
+    out = writeVertex(out, x + width, y, r, g, b, a);
+    out = writeVertex(out, x + width, y + height, r, g, b, a);
+    
+    out = writeVertex(out, x, y, r, g, b, a);
+    out = writeVertex(out, x + width, y + height, r, g, b, a);
+    writeVertex(out, x, y + height, r, g, b, a);
 }
 
 void RenderEngine::drawCircle(
@@ -321,48 +526,16 @@ void RenderEngine::drawCircle(
     // Ensure minimum number of segments
     segments = std::max(8, segments);
     
-    // Calculate vertices for a circle
-    std::vector<float> vertices;
-    vertices.reserve((segments + 2) * 6); // 6 floats per vertex
-    
-    // Center vertex
-    vertices.push_back(x);
-    vertices.push_back(y);
-    vertices.push_back(r);
-    vertices.push_back(g);
-    vertices.push_back(b);
-    vertices.push_back(a);
-    
-    // Outer vertices
-    for (int i = 0; i <= segments; ++i) {
-        float angle = 2.0f * M_PI * i / segments;
-        float vx = x + radius * cos(angle);
-        float vy = y + radius * sin(angle);
-        
-        vertices.push_back(vx);
-        vertices.push_back(vy);
-        vertices.push_back(r);
-        vertices.push_back(g);
-        vertices.push_back(b);
-        vertices.push_back(a);
-    }
-    
-    // Bind shader
-    glUseProgram(m_currentShader);
+    const float* unit = getUnitCircle(segments);
     
-    // Bind VAO
-    glBindVertexArray(m_vao);
-    
-    // Update VBO data
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
-    
-    // Draw
-    glDrawArrays(GL_TRIANGLE_FAN, 0, segments + 2);
-    
-    // Unbind
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    // One triangle per segment, so circles batch with everything else
+    // (a triangle fan would need a draw call of its own)
+    float* out = appendVertices(segments * 3);
+    for (int i = 0; i < segments; ++i) {
+        out = writeVertex(out, x, y, r, g, b, a);
+        out = writeVertex(out, x + radius * unit[i * 2], y + radius * unit[i * 2 + 1], r, g, b, a);
+        out = writeVertex(out, x + radius * unit[i * 2 + 2], y + radius * unit[i * 2 + 3], r, g, b, a);
+    }
 }
 
 void RenderEngine::drawLine(
@@ -386,34 +559,15 @@ void RenderEngine::drawLine(
     float px = -dy * (thickness * 0.5f);
     float py = dx * (thickness * 0.5f);
     
-    // Calculate the four corners of the line segment
-    float vertices[] = {
-        // Positions (x, y)            // Colors (r, g, b, a)
-        x1 + px, y1 + py,              r, g, b, a,
-        x2 + px, y2 + py,              r, g, b, a,
-        x2 - px, y2 - py,              r, g, b, a,
-        
-        x1 + px, y1 + py,              r, g, b, a,
-        x2 - px, y2 - py,              r, g, b, a,
-        x1 - px, y1 - py,              r, g, b, a
-    };
-    
-    // Bind shader
-    glUseProgram(m_currentShader);
-    
-    // Bind VAO
-    glBindVertexArray(m_vao);
+    // The four corners of the line segment as two triangles
+    float* out = appendVertices(6);
+    out = writeVertex(out, x1 + px, y1 + py, r, g, b, a);
+    out = writeVertex(out, x2 + px, y2 + py, r, g, b, a);
+    out = writeVertex(out, x2 - px, y2 - py, r, g, b, a);
     
-    // Update VBO data
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-    
-    // Draw
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    // Unbind
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    out = writeVertex(out, x1 + px, y1 + py, r, g, b, a);
+    out = writeVertex(out, x2 - px, y2 - py, r, g, b, a);
+    writeVertex(out, x1 - px, y1 - py, r, g, b, a);
 }
 
 void RenderEngine::drawLines(
@@ -424,7 +578,7 @@ void RenderEngine::drawLines(
         return; // Need at least 2 points for a line
     }
     
-    // Draw each line segment
+    // Each segment lands in the same batch
     for (int i = 0; i < count - 1; ++i) {
         drawLine(
             points[i * 2], points[i * 2 + 1],
@@ -446,4 +600,26 @@ void RenderEngine::drawPoints(
             r, g, b, a
         );
     }
-}
\ No newline at end of file
+}
+
+void RenderEngine::drawCircleInstanced(
+    float x, float y, float radius,
+    float r, float g, float b, float a
+) {
+    // Triangles submitted before this must be drawn first
+    flushVertices();
+    
+    if (m_circles.size() >= static_cast<size_t>(kMaxBatchCircles)) {
+        flushCircles();
+    }
+    
+    CircleInstance circle;
+    circle.x = x;
+    circle.y = y;
+    circle.radius = radius;
+    circle.color[0] = static_cast<uint8_t>(std::clamp(r, 0.0f, 1.0f) * 255.0f + 0.5f);
+    circle.color[1] = static_cast<uint8_t>(std::clamp(g, 0.0f, 1.0f) * 255.0f + 0.5f);
+    circle.color[2] = static_cast<uint8_t>(std::clamp(b, 0.0f, 1.0f) * 255.0f + 0.5f);
+    circle.color[3] = static_cast<uint8_t>(std::clamp(a, 0.0f, 1.0f) * 255.0f + 0.5f);
+    m_circles.push_back(circle);
+}
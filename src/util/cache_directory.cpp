@@ -0,0 +1,31 @@
+#include <iostream>
+#include <cstdlib>
+#include <filesystem>
+#include <system_error>
+#include "util/cache_directory.h"
+
+std::string getCacheDirectory() {
+    std::filesystem::path base;
+    
+    const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    if (xdgCache && xdgCache[0] != '\0') {
+        base = xdgCache;
+    } else if (home && home[0] != '\0') {
+        base = std::filesystem::path(home) / ".cache";
+    } else {
+        return "";
+    }
+    
+    std::filesystem::path directory = base / "musicvis";
+    
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Failed to create cache directory " << directory.string()
+                  << ": " << error.message() << std::endl;
+        return "";
+    }
+    
+    return directory.string();
+}
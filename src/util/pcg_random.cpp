@@ -0,0 +1,70 @@
+#include <random>
+#include "util/pcg_random.h"
+
+// LCG multiplier from the PCG reference implementation
+static const uint64_t kMultiplier = 6364136223846793005ull;
+
+// 2^-24: the top 24 bits of a draw fill a float's mantissa exactly
+static const float kUnitScale = 1.0f / 16777216.0f;
+
+PcgRandom::PcgRandom(uint64_t seed, uint64_t stream)
+    : m_state(0)
+    , m_increment(1)
+{
+    this->seed(seed, stream);
+}
+
+void PcgRandom::seed(uint64_t seed, uint64_t stream) {
+    // Reference seeding: pick the stream, then mix the seed into the state
+    m_state = 0;
+    m_increment = (stream << 1) | 1u;
+    next();
+    m_state += seed;
+    next();
+}
+
+// XSH RR output: xorshift the high bits down, then rotate by the top 5
+static inline uint32_t permute(uint64_t state) {
+    uint32_t shifted = static_cast<uint32_t>(((state >> 18) ^ state) >> 27);
+    uint32_t rotation = static_cast<uint32_t>(state >> 59);
+    return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+}
+
+uint32_t PcgRandom::next() {
+    uint64_t state = m_state;
+    m_state = state * kMultiplier + m_increment;
+    return permute(state);
+}
+
+float PcgRandom::uniform() {
+    return static_cast<float>(next() >> 8) * kUnitScale;
+}
+
+float PcgRandom::uniform(float low, float high) {
+    return low + (high - low) * uniform();
+}
+
+void PcgRandom::fill(float* out, size_t count) {
+    fill(out, count, 0.0f, 1.0f);
+}
+
+void PcgRandom::fill(float* out, size_t count, float low, float high) {
+    // Same arithmetic as uniform(low, high), kept in registers across the loop
+    const float range = high - low;
+    uint64_t state = m_state;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t bits = permute(state);
+        state = state * kMultiplier + m_increment;
+        out[i] = low + range * (static_cast<float>(bits >> 8) * kUnitScale);
+    }
+    m_state = state;
+}
+
+void PcgRandom::fill(std::vector<float>& out) {
+    fill(out.data(), out.size());
+}
+
+uint64_t PcgRandom::randomSeed() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <system_error>
+#include "util/thread_pool.h"
+
+ThreadPool::ThreadPool()
+    : m_task(nullptr)
+    , m_count(0)
+    , m_next(0)
+    , m_active(0)
+    , m_generation(0)
+    , m_stopping(false)
+{
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+bool ThreadPool::start(int workerCount) {
+    stop();
+
+    m_stopping = false;
+    try {
+        for (int worker = 0; worker < workerCount; ++worker) {
+            m_workers.emplace_back(&ThreadPool::workerLoop, this, worker + 1);
+        }
+    } catch (const std::system_error& e) {
+        std::cerr << "Failed to start thread pool: " << e.what() << std::endl;
+        stop();
+        return false;
+    }
+
+    return true;
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    m_workers.clear();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, int)>& task) {
+    // Nothing to share: skip the wake-up round trip
+    if (m_workers.empty() || count <= 1) {
+        for (size_t index = 0; index < count; ++index) {
+            task(index, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_next = 0;
+        m_active = static_cast<int>(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    runTasks(0);
+
+    // The task is referenced until the last worker has finished with it
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_active == 0; });
+    m_task = nullptr;
+}
+
+int ThreadPool::getThreadCount() const {
+    return static_cast<int>(m_workers.size()) + 1;
+}
+
+void ThreadPool::workerLoop(int thread) {
+    uint64_t seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+            if (m_stopping) {
+                return;
+            }
+            seenGeneration = m_generation;
+        }
+
+        runTasks(thread);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_active == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runTasks(int thread) {
+    for (size_t index = m_next.fetch_add(1); index < m_count; index = m_next.fetch_add(1)) {
+        (*m_task)(index, thread);
+    }
+}
@@ -2,17 +2,20 @@
 #include <algorithm>
 #include "visualization/bar_visualizer.h"
 #include "render/render_engine.h"
+#include "analysis/analysis_frame.h"
 
 BarVisualizer::BarVisualizer(std::shared_ptr<RenderEngine> renderEngine)
     : Visualizer(renderEngine)
     , m_barCount(64)
     , m_baseColor{0.2f, 0.6f, 1.0f, 1.0f}  // Blue
     , m_beatColor{1.0f, 0.2f, 0.4f, 1.0f}  // Red
+    , m_wideColor{0.7f, 0.3f, 1.0f, 1.0f}  // Violet
     , m_barWidth(8.0f)
     , m_barSpacing(2.0f)
     , m_animationSpeed(8.0f)
     , m_beatDetected(false)
     , m_beatIntensity(0.0f)
+    , m_bandIntensity{0.0f, 0.0f, 0.0f}
 {
 }
 
@@ -28,14 +31,9 @@ bool BarVisualizer::initialize() {
     return true;
 }
 
-void BarVisualizer::update(
-    float deltaTime,
-    const std::vector<float>& audioData,
-    const std::vector<float>& frequencyData,
-    bool beatDetected
-) {
+void BarVisualizer::update(float deltaTime, const AnalysisFrame& frame) {
     // Update beat detection state
-    m_beatDetected = beatDetected;
+    m_beatDetected = frame.beatDetected;
     
     // Decay beat intensity
     m_beatIntensity *= std::max(0.0f, 1.0f - deltaTime * 3.0f);
@@ -45,34 +43,45 @@ void BarVisualizer::update(
         m_beatIntensity = 1.0f;
     }
     
-    // Update bar heights based on frequency data
-    if (!frequencyData.empty()) {
-        int binStep = std::max(1, static_cast<int>(frequencyData.size() / m_barCount));
+    // Each drum band pulses its own part of the spectrum: kick the bass bars,
+    // snare the middle, hi-hat the top
+    for (size_t band = 0; band < m_bandIntensity.size(); ++band) {
+        m_bandIntensity[band] *= std::max(0.0f, 1.0f - deltaTime * 6.0f);
+        if (frame.bandBeats.beatMask & (1u << band)) {
+            m_bandIntensity[band] = 1.0f;
+        }
+    }
+    
+    // Update bar heights based on the log-spaced bands, one band per bar
+    if (!frame.bands.empty()) {
+        int bandCount = static_cast<int>(frame.bands.size());
         
         for (int i = 0; i < m_barCount; ++i) {
-            int binIndex = i * binStep;
-            if (binIndex < frequencyData.size()) {
-                // Use logarithmic mapping for more natural visualization
-                float frequency = frequencyData[binIndex];
-                
-                // Boost low and high frequencies for aesthetic appeal
-                if (i < m_barCount / 4) {
-                    // Boost bass frequencies
-                    frequency *= 1.2f;
-                } else if (i > m_barCount * 3 / 4) {
-                    // Boost high frequencies
-                    frequency *= 1.1f;
-                }
-                
-                // Set target height
-                m_targetBarHeights[i] = std::min(1.0f, frequency);
-                
-                // Add beat effect
-                if (m_beatDetected) {
-                    m_targetBarHeights[i] *= (1.0f + m_beatIntensity * 0.5f);
-                }
+            int bandIndex = i * bandCount / m_barCount;
+            float frequency = frame.bands[bandIndex];
+            
+            // Boost low and high frequencies for aesthetic appeal, plus the
+            // pulse of the drum band covering this bar
+            float bandPulse;
+            if (i < m_barCount / 4) {
+                // Boost bass frequencies
+                frequency *= 1.2f;
+                bandPulse = m_bandIntensity[kKickBand];
+            } else if (i > m_barCount * 3 / 4) {
+                // Boost high frequencies
+                frequency *= 1.1f;
+                bandPulse = m_bandIntensity[kHiHatBand];
             } else {
-                m_targetBarHeights[i] = 0.0f;
+                bandPulse = m_bandIntensity[kSnareBand];
+            }
+            frequency *= 1.0f + bandPulse * 0.4f;
+            
+            // Set target height
+            m_targetBarHeights[i] = std::min(1.0f, frequency);
+            
+            // Add beat effect
+            if (m_beatDetected) {
+                m_targetBarHeights[i] *= (1.0f + m_beatIntensity * 0.5f);
             }
             
             // Smoothly animate to target height
@@ -82,10 +91,19 @@ void BarVisualizer::update(
             // Update bar color based on height and beat
             float beatFactor = m_beatIntensity * 0.6f;
             float heightFactor = m_barHeights[i] * 0.4f;
-            float colorMix = beatFactor + heightFactor;
+            float colorMix = std::min(1.0f, beatFactor + heightFactor + bandPulse * 0.3f);
+            
+            // Bands whose left and right channels are decorrelated lean
+            // toward the wide color; mono content stays on the base color
+            float width = 0.0f;
+            if (!frame.correlation.empty()) {
+                int stereoBand = i * static_cast<int>(frame.correlation.size()) / m_barCount;
+                width = std::min(1.0f, 1.0f - frame.correlation[stereoBand]) * 0.7f;
+            }
             
             for (int c = 0; c < 3; ++c) {
-                m_barColors[i][c] = m_baseColor[c] * (1.0f - colorMix) + m_beatColor[c] * colorMix;
+                float base = m_baseColor[c] * (1.0f - width) + m_wideColor[c] * width;
+                m_barColors[i][c] = base * (1.0f - colorMix) + m_beatColor[c] * colorMix;
             }
         }
     }
@@ -1,22 +1,20 @@
 #include <cmath>
-#include <random>
 #include <algorithm>
 #include "visualization/particle_visualizer.h"
 #include "render/render_engine.h"
+#include "analysis/analysis_frame.h"
 
-// Random number generator
-static std::random_device rd;
-static std::mt19937 gen(rd());
-static std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+// Random draws behind each spawned particle: jitter (2), direction (2),
+// speed (2), size, lifetime and colour variation (3)
+static const int kUniformsPerParticle = 11;
 
-// Helper to get a random float
-float getRandomFloat() {
-    return dis(gen);
-}
-
-ParticleVisualizer::ParticleVisualizer(std::shared_ptr<RenderEngine> renderEngine)
+ParticleVisualizer::ParticleVisualizer(std::shared_ptr<RenderEngine> renderEngine,
+                                       std::shared_ptr<ThreadPool> workerPool,
+                                       uint64_t seed,
+                                       int maxParticles)
     : Visualizer(renderEngine)
-    , m_maxParticles(800)  // Increased from 500 for more visual density
+    , m_workerPool(workerPool)
+    , m_maxParticles(std::max(1, maxParticles))
     , m_emissionRate(150.0f)  // Increased from 100.0f for more particles
     , m_emissionTimer(0.0f)
     , m_emitterX(0.0f)
@@ -29,6 +27,8 @@ ParticleVisualizer::ParticleVisualizer(std::shared_ptr<RenderEngine> renderEngin
     , m_trebleEnergy(0.0f)
     , m_beatCounter(0)
     , m_lastBeatTime(0.0f)
+    , m_seed(seed)
+    , m_pendingParticles(0)
 {
 }
 
@@ -37,7 +37,12 @@ ParticleVisualizer::~ParticleVisualizer() {
 
 bool ParticleVisualizer::initialize() {
     // Initialize particles
-    m_particles.reserve(m_maxParticles);
+    m_particles.initialize(m_maxParticles, m_workerPool);
+    
+    // Every activation replays the same random sequence
+    m_random.seed(m_seed);
+    m_emissions.clear();
+    m_pendingParticles = 0;
     
     // Get window dimensions
     int width, height;
@@ -59,18 +64,13 @@ bool ParticleVisualizer::initialize() {
     return true;
 }
 
-void ParticleVisualizer::update(
-    float deltaTime,
-    const std::vector<float>& audioData,
-    const std::vector<float>& frequencyData,
-    bool beatDetected
-) {
+void ParticleVisualizer::update(float deltaTime, const AnalysisFrame& frame) {
     // Update time tracker
     m_totalTime += deltaTime;
     
     // Update beat detection state
     bool previousBeatState = m_beatDetected;
-    m_beatDetected = beatDetected;
+    m_beatDetected = frame.beatDetected;
     
     // Detect if this is a new beat
     bool newBeat = !previousBeatState && m_beatDetected;
@@ -97,40 +97,24 @@ void ParticleVisualizer::update(
     }
     
     // Calculate audio energy in different frequency bands
-    if (!frequencyData.empty()) {
-        // Save frequency data for visualization
-        m_lastFrequencyData = frequencyData;
+    if (!frame.bands.empty()) {
+        // Save band data for visualization
+        m_lastBandData = frame.bands;
+        
+        // Low frequency (bass) energy from the lowest log bands, up to ~100 Hz
+        float bassAverage = averageBands(frame.bands, 0.0f, 0.25f);
         
-        // Calculate low frequency (bass) energy - lower range for more accuracy
-        int bassBins = std::min(6, static_cast<int>(frequencyData.size() / 10));
-        float bassSum = 0.0f;
-        for (int i = 0; i < bassBins; ++i) {
-            bassSum += frequencyData[i];
-        }
         // Smoother bass energy transition but more responsive
-        m_bassEnergy = m_bassEnergy * 0.7f + (bassSum / bassBins) * 0.3f;
+        m_bassEnergy = m_bassEnergy * 0.7f + bassAverage * 0.3f;
         
         // Apply more boost to bass for visualization
         m_bassEnergy = std::min(1.0f, m_bassEnergy * 1.5f);
         
-        // Calculate mid frequency energy
-        int midStart = static_cast<int>(frequencyData.size() * 0.1f);
-        int midEnd = static_cast<int>(frequencyData.size() * 0.5f);
-        float midSum = 0.0f;
-        for (int i = midStart; i < midEnd; ++i) {
-            midSum += frequencyData[i];
-        }
-        float midEnergy = midSum / (midEnd - midStart);
+        // High frequency (treble) energy from the top log bands, above ~2.5 kHz
+        float trebleAverage = averageBands(frame.bands, 0.7f, 1.0f);
         
-        // Calculate high frequency (treble) energy
-        int trebleStart = static_cast<int>(frequencyData.size() * 0.6f);
-        int trebleBins = frequencyData.size() - trebleStart;
-        float trebleSum = 0.0f;
-        for (int i = trebleStart; i < frequencyData.size(); ++i) {
-            trebleSum += frequencyData[i];
-        }
         // Smoother treble energy transition
-        m_trebleEnergy = m_trebleEnergy * 0.7f + (trebleSum / trebleBins) * 0.3f;
+        m_trebleEnergy = m_trebleEnergy * 0.7f + trebleAverage * 0.3f;
         
         // More boost to treble energy for visualization
         m_trebleEnergy = std::min(1.0f, m_trebleEnergy * 1.4f);
@@ -143,6 +127,32 @@ void ParticleVisualizer::update(
     int width, height;
     m_renderEngine->getViewportSize(width, height);
     
+    // Kick: a dense burst from the centre scaled by the kick band energy
+    if (frame.bandBeats.beatMask & (1u << kKickBand)) {
+        float kickEnergy = frame.bandBeats.energies.size() > kKickBand ? frame.bandBeats.energies[kKickBand] : 0.5f;
+        spawnParticles(12, width * 0.5f, height * 0.5f, 0.5f + kickEnergy, m_beatColor);
+    }
+    
+    // Snare: a burst from a random point on a ring around the centre
+    if (frame.bandBeats.beatMask & (1u << kSnareBand)) {
+        float angle = m_random.uniform() * 2.0f * M_PI;
+        float radius = std::min(width, height) * 0.3f;
+        spawnParticles(
+            8,
+            width * 0.5f + cos(angle) * radius,
+            height * 0.5f + sin(angle) * radius,
+            0.6f,
+            m_altColors[m_beatCounter % m_altColors.size()]
+        );
+    }
+    
+    // Hi-hat: a few small sparks anywhere on screen
+    if (frame.bandBeats.beatMask & (1u << kHiHatBand)) {
+        for (int i = 0; i < 3; ++i) {
+            spawnParticles(1, m_random.uniform() * width, m_random.uniform() * height, 0.1f, {1.0f, 1.0f, 1.0f, 1.0f});
+        }
+    }
+    
     // Emit particles based on audio
     // More responsive emission rate based on audio energy
     float baseEmissionRate = m_emissionRate * (1.0f + m_beatIntensity);
@@ -182,18 +192,19 @@ void ParticleVisualizer::update(
             }
             
             // Frequency-based emission pattern
-            if (!m_lastFrequencyData.empty()) {
+            if (!m_lastBandData.empty()) {
                 // Use different frequency bands for each emitter
-                int binOffset = (emitter * m_lastFrequencyData.size() / numEmitters) % m_lastFrequencyData.size();
-                int binIndex = (binOffset + static_cast<int>(getRandomFloat() * m_lastFrequencyData.size() / 4)) % m_lastFrequencyData.size();
-                float binValue = m_lastFrequencyData[binIndex];
+                int bandCount = static_cast<int>(m_lastBandData.size());
+                int bandOffset = (emitter * bandCount / numEmitters) % bandCount;
+                int bandIndex = (bandOffset + static_cast<int>(m_random.uniform() * bandCount / 4)) % bandCount;
+                float binValue = m_lastBandData[bandIndex];
                 
                 // Add some randomness based on frequency
-                float angle = (static_cast<float>(binIndex) / m_lastFrequencyData.size()) * 2.0f * M_PI;
+                float angle = (static_cast<float>(bandIndex) / bandCount) * 2.0f * M_PI;
                 float distance = (height * 0.2f) * binValue;
                 
-                spawnX += cos(angle) * distance * getRandomFloat();
-                spawnY += sin(angle) * distance * getRandomFloat();
+                spawnX += cos(angle) * distance * m_random.uniform();
+                spawnY += sin(angle) * distance * m_random.uniform();
             }
             
             // Spawn more particles during beat
@@ -225,6 +236,9 @@ void ParticleVisualizer::update(
             );
         }
     }
+    
+    // Build everything requested this frame
+    flushEmissions();
 }
 
 void ParticleVisualizer::render() {
@@ -232,32 +246,45 @@ void ParticleVisualizer::render() {
         return;
     }
     
-    // Draw each particle with potential glow effect during beats
-    for (const Particle& particle : m_particles) {
+    // Draw each particle with potential glow effect during beats. Every
+    // circle is an instance of the renderer's unit-circle mesh, so all of
+    // them go out in a single draw call.
+    const float* x = m_particles.getX();
+    const float* y = m_particles.getY();
+    const float* size = m_particles.getSize();
+    const float* life = m_particles.getLife();
+    const float* maxLife = m_particles.getMaxLife();
+    const float* red = m_particles.getRed();
+    const float* green = m_particles.getGreen();
+    const float* blue = m_particles.getBlue();
+    const float* alpha = m_particles.getAlpha();
+    const bool glow = m_beatIntensity > 0.5f;
+    
+    for (size_t i = 0; i < m_particles.size(); ++i) {
+        float fade = life[i] / maxLife[i];
+        
         // Normal particle
-        m_renderEngine->drawCircle(
-            particle.x,
-            particle.y,
-            particle.size,
-            8,  // Segments
-            particle.color[0],
-            particle.color[1],
-            particle.color[2],
-            particle.color[3] * (particle.life / particle.maxLife)  // Fade out
+        m_renderEngine->drawCircleInstanced(
+            x[i],
+            y[i],
+            size[i],
+            red[i],
+            green[i],
+            blue[i],
+            alpha[i] * fade  // Fade out
         );
         
         // Add glow effect for larger particles during beats
-        if (m_beatIntensity > 0.5f && particle.size > 4.0f) {
+        if (glow && size[i] > 4.0f) {
             // Draw a larger, more transparent circle for glow
-            m_renderEngine->drawCircle(
-                particle.x,
-                particle.y,
-                particle.size * 1.8f,  // Larger size for glow
-                12,  // More segments for smoother glow
-                particle.color[0],
-                particle.color[1],
-                particle.color[2],
-                particle.color[3] * 0.3f * m_beatIntensity * (particle.life / particle.maxLife)  // Transparent glow
+            m_renderEngine->drawCircleInstanced(
+                x[i],
+                y[i],
+                size[i] * 1.8f,  // Larger size for glow
+                red[i],
+                green[i],
+                blue[i],
+                alpha[i] * 0.3f * m_beatIntensity * fade  // Transparent glow
             );
         }
     }
@@ -268,10 +295,6 @@ const char* ParticleVisualizer::getName() const {
 }
 
 void ParticleVisualizer::spawnParticles(int count, float x, float y, float energy, const std::array<float, 4>& baseColor) {
-    // Get window dimensions
-    int width, height;
-    m_renderEngine->getViewportSize(width, height);
-    
     // Calculate color based on beat and energy
     std::array<float, 4> particleColor;
     float beatFactor = m_beatIntensity;
@@ -283,103 +306,153 @@ void ParticleVisualizer::spawnParticles(int count, float x, float y, float energ
     }
     particleColor[3] = 1.0f;
     
-    for (int i = 0; i < count; ++i) {
-        // Don't exceed max particles
-        if (m_particles.size() >= m_maxParticles) {
+    // Don't exceed max particles, counting the ones already requested
+    size_t room = m_particles.capacity() - m_particles.size() - m_pendingParticles;
+    count = std::min(count, static_cast<int>(room));
+    if (count <= 0) {
+        return;
+    }
+    
+    // Built with the rest of the frame's particles in flushEmissions()
+    Emission emission;
+    emission.first = m_pendingParticles;
+    emission.x = x;
+    emission.y = y;
+    emission.energy = energy;
+    emission.color = particleColor;
+    m_emissions.push_back(emission);
+    m_pendingParticles += count;
+}
+
+void ParticleVisualizer::flushEmissions() {
+    if (m_pendingParticles == 0) {
+        return;
+    }
+    
+    // Get window dimensions
+    int width, height;
+    m_renderEngine->getViewportSize(width, height);
+    
+    // One seed per frame from the visualizer's sequence keeps a run replayable
+    uint64_t seed = static_cast<uint64_t>(m_random.next()) << 32;
+    seed |= m_random.next();
+    
+    m_particles.spawnBatch(m_pendingParticles, seed, [&](size_t index, PcgRandom& random, ParticleSpawn& particle) {
+        // The emission a particle belongs to is the last one starting at or before it
+        auto emission = std::upper_bound(m_emissions.begin(), m_emissions.end(), index,
+            [](size_t i, const Emission& e) { return i < e.first; }) - 1;
+        buildParticle(*emission, width, height, random, particle);
+    });
+    
+    m_emissions.clear();
+    m_pendingParticles = 0;
+}
+
+void ParticleVisualizer::buildParticle(const Emission& emission, int width, int height,
+                                       PcgRandom& random, ParticleSpawn& particle) const {
+    // Draw every random value the particle needs in one pass
+    float u[kUniformsPerParticle];
+    random.fill(u, kUniformsPerParticle);
+    
+    float px = emission.x + (u[0] - 0.5f) * 10.0f;
+    float py = emission.y + (u[1] - 0.5f) * 10.0f;
+    
+    // Velocity based on energy and beat state
+    float velMagnitude;
+    if (m_beatDetected) {
+        velMagnitude = 150.0f + emission.energy * 200.0f; // Much faster on beats
+    } else {
+        velMagnitude = 50.0f + emission.energy * 100.0f;
+    }
+    
+    // Create more interesting patterns based on beat count
+    float dirX, dirY;
+    
+    // Different emission patterns based on beat count
+    switch (m_beatCounter % 4) {
+        case 0: // Circular pattern
+            {
+                float angle = u[2] * 2.0f * M_PI;
+                dirX = cos(angle);
+                dirY = sin(angle);
+            }
             break;
-        }
-        
-        Particle p;
-        p.x = x + (getRandomFloat() - 0.5f) * 10.0f;
-        p.y = y + (getRandomFloat() - 0.5f) * 10.0f;
-        
-        // Velocity based on energy and beat state
-        float velMagnitude;
-        if (m_beatDetected) {
-            velMagnitude = 150.0f + energy * 200.0f; // Much faster on beats
-        } else {
-            velMagnitude = 50.0f + energy * 100.0f;
-        }
-        
-        // Create more interesting patterns based on beat count
-        float dirX, dirY;
-        
-        // Different emission patterns based on beat count
-        switch (m_beatCounter % 4) {
-            case 0: // Circular pattern
-                {
-                    float angle = getRandomFloat() * 2.0f * M_PI;
-                    dirX = cos(angle);
-                    dirY = sin(angle);
-                }
-                break;
-                
-            case 1: // Radial burst from center
-                {
-                    dirX = p.x - width * 0.5f;
-                    dirY = p.y - height * 0.5f;
-                    float dirLength = std::sqrt(dirX * dirX + dirY * dirY);
-                    
-                    if (dirLength > 0.0001f) {
-                        dirX /= dirLength;
-                        dirY /= dirLength;
-                    } else {
-                        dirX = getRandomFloat() * 2.0f - 1.0f;
-                        dirY = getRandomFloat() * 2.0f - 1.0f;
-                    }
-                }
-                break;
+            
+        case 1: // Radial burst from center
+            {
+                dirX = px - width * 0.5f;
+                dirY = py - height * 0.5f;
+                float dirLength = std::sqrt(dirX * dirX + dirY * dirY);
                 
-            case 2: // Spiral pattern
-                {
-                    float angle = getRandomFloat() * 2.0f * M_PI;
-                    dirX = cos(angle + m_totalTime);
-                    dirY = sin(angle + m_totalTime);
+                if (dirLength > 0.0001f) {
+                    dirX /= dirLength;
+                    dirY /= dirLength;
+                } else {
+                    dirX = u[2] * 2.0f - 1.0f;
+                    dirY = u[3] * 2.0f - 1.0f;
                 }
-                break;
-                
-            case 3: // Random directions
-            default:
-                dirX = getRandomFloat() * 2.0f - 1.0f;
-                dirY = getRandomFloat() * 2.0f - 1.0f;
-                break;
-        }
-        
-        // Normalize direction
-        float dirLength = std::sqrt(dirX * dirX + dirY * dirY);
-        if (dirLength > 0.0001f) {
-            dirX /= dirLength;
-            dirY /= dirLength;
-        }
-        
-        p.vx = dirX * velMagnitude * (0.5f + getRandomFloat() * 0.5f);
-        p.vy = dirY * velMagnitude * (0.5f + getRandomFloat() * 0.5f);
-        
-        // Size based on energy with more variety
-        if (m_beatDetected) {
-            // Bigger particles during beats
-            p.size = 3.0f + energy * 12.0f * getRandomFloat();
-        } else {
-            p.size = 2.0f + energy * 8.0f * getRandomFloat();
-        }
-        
-        // Lifetime based on size and beat state
-        if (m_beatDetected) {
-            p.maxLife = 1.5f + getRandomFloat() * 1.5f; // Longer life during beats
-        } else {
-            p.maxLife = 1.0f + getRandomFloat() * 2.0f;
-        }
-        p.life = p.maxLife;
-        
-        // Color with slight variation
-        p.color = particleColor;
-        for (int c = 0; c < 3; ++c) {
-            p.color[c] += (getRandomFloat() - 0.5f) * 0.2f;
-            p.color[c] = std::clamp(p.color[c], 0.0f, 1.0f);
-        }
-        
-        m_particles.push_back(p);
+            }
+            break;
+            
+        case 2: // Spiral pattern
+            {
+                float angle = u[2] * 2.0f * M_PI;
+                dirX = cos(angle + m_totalTime);
+                dirY = sin(angle + m_totalTime);
+            }
+            break;
+            
+        case 3: // Random directions
+        default:
+            dirX = u[2] * 2.0f - 1.0f;
+            dirY = u[3] * 2.0f - 1.0f;
+            break;
     }
+    
+    // Normalize direction
+    float dirLength = std::sqrt(dirX * dirX + dirY * dirY);
+    if (dirLength > 0.0001f) {
+        dirX /= dirLength;
+        dirY /= dirLength;
+    }
+    
+    float vx = dirX * velMagnitude * (0.5f + u[4] * 0.5f);
+    float vy = dirY * velMagnitude * (0.5f + u[5] * 0.5f);
+    
+    // Size based on energy with more variety
+    float size;
+    if (m_beatDetected) {
+        // Bigger particles during beats
+        size = 3.0f + emission.energy * 12.0f * u[6];
+    } else {
+        size = 2.0f + emission.energy * 8.0f * u[6];
+    }
+    
+    // Lifetime based on size and beat state
+    float life;
+    if (m_beatDetected) {
+        life = 1.5f + u[7] * 1.5f; // Longer life during beats
+    } else {
+        life = 1.0f + u[7] * 2.0f;
+    }
+    
+    // Color with slight variation
+    std::array<float, 4> color = emission.color;
+    for (int c = 0; c < 3; ++c) {
+        color[c] += (u[8 + c] - 0.5f) * 0.2f;
+        color[c] = std::clamp(color[c], 0.0f, 1.0f);
+    }
+    
+    particle.x = px;
+    particle.y = py;
+    particle.vx = vx;
+    particle.vy = vy;
+    particle.size = size;
+    particle.life = life;
+    particle.r = color[0];
+    particle.g = color[1];
+    particle.b = color[2];
+    particle.a = color[3];
 }
 
 void ParticleVisualizer::updateParticles(float deltaTime) {
@@ -387,54 +460,20 @@ void ParticleVisualizer::updateParticles(float deltaTime) {
     int width, height;
     m_renderEngine->getViewportSize(width, height);
     
-    // Update each particle
-    for (auto& p : m_particles) {
-        // Update position
-        p.x += p.vx * deltaTime;
-        p.y += p.vy * deltaTime;
-        
-        // Apply gravity with music-reactive strength
-        float gravityStrength = 30.0f * (1.0f + m_bassEnergy * 2.0f);
-        p.vy += gravityStrength * deltaTime;
-        
-        // Apply drag that varies with music
-        float dragFactor = 0.97f + m_trebleEnergy * 0.02f;
-        p.vx *= dragFactor;
-        p.vy *= dragFactor;
-        
-        // Bounce off edges with damping
-        if (p.x < 0) {
-            p.x = 0;
-            p.vx = -p.vx * 0.8f;
-        } else if (p.x > width) {
-            p.x = width;
-            p.vx = -p.vx * 0.8f;
-        }
-        
-        if (p.y < 0) {
-            p.y = 0;
-            p.vy = -p.vy * 0.8f;
-        } else if (p.y > height) {
-            p.y = height;
-            p.vy = -p.vy * 0.8f;
-        }
-        
-        // Update lifetime with music-reactive decay
-        float lifeDrain = deltaTime;
-        if (m_beatDetected) {
-            // Slower decay during beats for sustained visuals
-            lifeDrain *= 0.7f;
-        }
-        p.life -= lifeDrain;
-    }
+    ParticleStep step;
+    step.deltaTime = deltaTime;
+    step.width = static_cast<float>(width);
+    step.height = static_cast<float>(height);
+    
+    // Gravity with music-reactive strength
+    step.gravity = 30.0f * (1.0f + m_bassEnergy * 2.0f);
     
-    // Remove dead particles
-    m_particles.erase(
-        std::remove_if(
-            m_particles.begin(),
-            m_particles.end(),
-            [](const Particle& p) { return p.life <= 0.0f; }
-        ),
-        m_particles.end()
-    );
-}
\ No newline at end of file
+    // Drag that varies with music
+    step.drag = 0.97f + m_trebleEnergy * 0.02f;
+    
+    // Slower decay during beats for sustained visuals
+    step.lifeDrain = m_beatDetected ? deltaTime * 0.7f : deltaTime;
+    
+    // Integrate, bounce off the edges and drop dead particles
+    m_particles.update(step);
+}
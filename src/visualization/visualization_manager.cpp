@@ -4,9 +4,16 @@
 #include "visualization/wave_visualizer.h"
 #include "visualization/particle_visualizer.h"
 #include "render/render_engine.h"
+#include "analysis/analysis_frame.h"
 
-VisualizationManager::VisualizationManager(std::shared_ptr<RenderEngine> renderEngine)
+VisualizationManager::VisualizationManager(std::shared_ptr<RenderEngine> renderEngine,
+                                           std::shared_ptr<ThreadPool> workerPool,
+                                           uint64_t seed,
+                                           int maxParticles)
     : m_renderEngine(renderEngine)
+    , m_workerPool(workerPool)
+    , m_seed(seed)
+    , m_maxParticles(maxParticles)
     , m_currentVisualizer(0)
 {
 }
@@ -44,25 +51,11 @@ void VisualizationManager::shutdown() {
     m_visualizers.clear();
 }
 
-void VisualizationManager::update(
-    float deltaTime,
-    const std::vector<float>& audioData,
-    const std::vector<float>& frequencyData,
-    bool beatDetected
-) {
+void VisualizationManager::update(float deltaTime, const AnalysisFrame& frame) {
+    // Runs every frame on the render thread, so nothing here writes to the
+    // console; the frame counters go into the window title instead
     if (m_currentVisualizer < m_visualizers.size()) {
-        std::cout << "Updating visualizer: " << m_visualizers[m_currentVisualizer]->getName() << std::endl;
-        std::cout << "  - Audio data size: " << audioData.size() << std::endl;
-        std::cout << "  - Frequency data size: " << frequencyData.size() << std::endl;
-        std::cout << "  - Beat detected: " << (beatDetected ? "Yes" : "No") << std::endl;
-        
-        m_visualizers[m_currentVisualizer]->update(
-            deltaTime,
-            audioData,
-            frequencyData,
-            beatDetected
-        );
-        std::cout << "Visualizer updated" << std::endl;
+        m_visualizers[m_currentVisualizer]->update(deltaTime, frame);
     }
 }
 
@@ -115,5 +108,5 @@ void VisualizationManager::addBuiltInVisualizers() {
     m_visualizers.push_back(std::make_unique<WaveVisualizer>(m_renderEngine));
     
     // Add particle visualizer
-    m_visualizers.push_back(std::make_unique<ParticleVisualizer>(m_renderEngine));
+    m_visualizers.push_back(std::make_unique<ParticleVisualizer>(m_renderEngine, m_workerPool, m_seed, m_maxParticles));
 }
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "visualization/visualizer.h"
 #include "render/render_engine.h"
 
@@ -7,4 +8,20 @@ Visualizer::Visualizer(std::shared_ptr<RenderEngine> renderEngine)
 }
 
 Visualizer::~Visualizer() {
+}
+
+float Visualizer::averageBands(const std::vector<float>& bandData, float start, float end) {
+    if (bandData.empty()) {
+        return 0.0f;
+    }
+    
+    int count = static_cast<int>(bandData.size());
+    int first = std::clamp(static_cast<int>(start * count), 0, count - 1);
+    int last = std::clamp(static_cast<int>(end * count), first + 1, count);
+    
+    float sum = 0.0f;
+    for (int i = first; i < last; ++i) {
+        sum += bandData[i];
+    }
+    return sum / (last - first);
 }
\ No newline at end of file
@@ -2,12 +2,25 @@
 #include <algorithm>
 #include "visualization/wave_visualizer.h"
 #include "render/render_engine.h"
+#include "analysis/analysis_frame.h"
+
+// How far the base color is pulled toward the dominant pitch class hue
+static const float kToneTint = 0.6f;
+
+// Fully saturated color for a hue in turns (0-1)
+static void hueToRgb(float hue, float rgb[3]) {
+    for (int c = 0; c < 3; ++c) {
+        float k = std::fmod(5 - 2 * c + hue * 6.0f, 6.0f);
+        rgb[c] = 1.0f - std::max(0.0f, std::min(1.0f, std::min(k, 4.0f - k)));
+    }
+}
 
 WaveVisualizer::WaveVisualizer(std::shared_ptr<RenderEngine> renderEngine)
     : Visualizer(renderEngine)
     , m_pointCount(100)
     , m_baseColor{0.0f, 0.8f, 0.8f, 1.0f}  // Cyan
     , m_beatColor{1.0f, 0.4f, 0.8f, 1.0f}  // Pink
+    , m_toneColor{0.0f, 0.8f, 0.8f, 1.0f}
     , m_amplitude(100.0f)
     , m_frequency(0.5f)
     , m_phase(0.0f)
@@ -28,14 +41,9 @@ bool WaveVisualizer::initialize() {
     return true;
 }
 
-void WaveVisualizer::update(
-    float deltaTime,
-    const std::vector<float>& audioData,
-    const std::vector<float>& frequencyData,
-    bool beatDetected
-) {
+void WaveVisualizer::update(float deltaTime, const AnalysisFrame& frame) {
     // Update beat detection state
-    m_beatDetected = beatDetected;
+    m_beatDetected = frame.beatDetected;
     
     // Decay beat intensity
     m_beatIntensity *= std::max(0.0f, 1.0f - deltaTime * 3.0f);
@@ -55,26 +63,10 @@ void WaveVisualizer::update(
         m_phase -= 2.0f * M_PI;
     }
     
-    // Adjust frequency and amplitude based on audio
-    float freqSum = 0.0f;
-    float ampSum = 0.0f;
-    
-    if (!frequencyData.empty()) {
-        // Average low frequencies for bass effect
-        int bassBins = std::min(8, static_cast<int>(frequencyData.size() / 8));
-        for (int i = 0; i < bassBins; ++i) {
-            freqSum += frequencyData[i];
-        }
-        freqSum /= bassBins;
-        
-        // Average mid frequencies for amplitude effect
-        int midStart = frequencyData.size() / 8;
-        int midEnd = frequencyData.size() / 2;
-        for (int i = midStart; i < midEnd; ++i) {
-            ampSum += frequencyData[i];
-        }
-        ampSum /= (midEnd - midStart);
-    }
+    // Adjust frequency and amplitude based on audio: bass (lowest 30% of the
+    // log bands, up to ~160 Hz) drives the wave frequency, mids the amplitude
+    float freqSum = averageBands(frame.bands, 0.0f, 0.3f);
+    float ampSum = averageBands(frame.bands, 0.3f, 0.7f);
     
     // Adjust frequency and amplitude
     float targetFreq = 0.5f + freqSum * 2.0f;
@@ -89,6 +81,10 @@ void WaveVisualizer::update(
     m_frequency += (targetFreq - m_frequency) * std::min(1.0f, deltaTime * 5.0f);
     m_amplitude += (targetAmp - m_amplitude) * std::min(1.0f, deltaTime * 5.0f);
     
+    // Noisier sounds (flatter spectrum) mix in more of the second sine, so
+    // the wave turns rougher
+    float roughness = 0.3f + std::min(1.0f, frame.features.flatness * 2.0f) * 0.5f;
+    
     // Update wave points
     float centerY = height * 0.5f;
     float xStep = static_cast<float>(width) / (m_pointCount - 1);
@@ -100,18 +96,42 @@ void WaveVisualizer::update(
         float y = centerY + sin(m_phase + i * 0.1f * m_frequency) * m_amplitude;
         
         // Add another sine wave for complexity
-        y += sin(m_phase * 0.7f + i * 0.2f) * m_amplitude * 0.3f;
+        y += sin(m_phase * 0.7f + i * 0.2f) * m_amplitude * roughness;
         
         // Store point
         m_wavePoints[i * 2] = x;
         m_wavePoints[i * 2 + 1] = y;
     }
     
+    // Tint the base color by the dominant pitch class, one hue per note
+    // around the circle of fifths so related keys get related colors. The
+    // tint fades out when no pitch class stands out from the rest.
+    float targetTone[3] = {m_baseColor[0], m_baseColor[1], m_baseColor[2]};
+    if (frame.chroma.size() == 12) {
+        int dominant = static_cast<int>(std::max_element(frame.chroma.begin(), frame.chroma.end()) - frame.chroma.begin());
+        float mean = 0.0f;
+        for (float value : frame.chroma) {
+            mean += value;
+        }
+        mean /= 12.0f;
+        
+        float rgb[3];
+        hueToRgb(((dominant * 7) % 12) / 12.0f, rgb);
+        float tint = kToneTint * std::max(0.0f, 1.0f - mean * 2.0f);
+        for (int c = 0; c < 3; ++c) {
+            targetTone[c] += (rgb[c] * 0.8f - targetTone[c]) * tint;
+        }
+    }
+    
+    for (int c = 0; c < 3; ++c) {
+        m_toneColor[c] += (targetTone[c] - m_toneColor[c]) * std::min(1.0f, deltaTime * 2.0f);
+    }
+    
     // Update color based on beat
     float beatFactor = m_beatIntensity;
     
     for (int c = 0; c < 3; ++c) {
-        m_waveColor[c] = m_baseColor[c] * (1.0f - beatFactor) + m_beatColor[c] * beatFactor;
+        m_waveColor[c] = m_toneColor[c] * (1.0f - beatFactor) + m_beatColor[c] * beatFactor;
     }
     
     // Update line thickness based on beat
@@ -0,0 +1,92 @@
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "visualization/particle_system.h"
+#include "util/pcg_random.h"
+#include "util/thread_pool.h"
+
+// Enough particles for dozens of update and spawn chunks
+static const size_t kCapacity = 60000;
+static const int kFrames = 90;
+
+// Every field of every live particle, in slot order
+static std::vector<float> snapshot(const ParticleSystem& system) {
+    std::vector<float> state;
+    for (const float* field : {system.getX(), system.getY(), system.getVelocityX(), system.getVelocityY(),
+                               system.getSize(), system.getLife(), system.getMaxLife(), system.getRed(),
+                               system.getGreen(), system.getBlue(), system.getAlpha()}) {
+        state.insert(state.end(), field, field + system.size());
+    }
+    return state;
+}
+
+// Bursts of varying size from a moving point, on a pool with workerCount
+// workers (-1 for no pool), like ParticleVisualizer drives the system
+static std::vector<float> simulate(int workerCount) {
+    std::shared_ptr<ThreadPool> pool;
+    if (workerCount >= 0) {
+        pool = std::make_shared<ThreadPool>();
+        if (!pool->start(workerCount)) {
+            return {};
+        }
+    }
+
+    ParticleSystem system;
+    system.initialize(kCapacity, pool);
+
+    ParticleStep step;
+    step.deltaTime = 1.0f / 60.0f;
+    step.gravity = 45.0f;
+    step.drag = 0.98f;
+    step.lifeDrain = 1.0f / 60.0f;
+    step.width = 1280.0f;
+    step.height = 720.0f;
+
+    PcgRandom frameRandom(42);
+    for (int frame = 0; frame < kFrames; ++frame) {
+        system.update(step);
+
+        float originX = frameRandom.uniform(0.0f, step.width);
+        float originY = frameRandom.uniform(0.0f, step.height);
+        size_t burst = 1000 + frameRandom.next() % 4000;
+        system.spawnBatch(burst, frameRandom.next(), [&](size_t, PcgRandom& random, ParticleSpawn& p) {
+            p.x = originX + random.uniform(-5.0f, 5.0f);
+            p.y = originY + random.uniform(-5.0f, 5.0f);
+            p.vx = random.uniform(-400.0f, 400.0f);
+            p.vy = random.uniform(-400.0f, 400.0f);
+            p.size = random.uniform(2.0f, 14.0f);
+            p.life = random.uniform(0.2f, 1.5f);
+            p.r = random.uniform();
+            p.g = random.uniform();
+            p.b = random.uniform();
+            p.a = 1.0f;
+        });
+    }
+    return snapshot(system);
+}
+
+int main() {
+    // Serial run on the calling thread is the reference
+    std::vector<float> reference = simulate(-1);
+    if (reference.empty()) {
+        std::cerr << "Reference run left no particles" << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    for (int workerCount : {0, 1, 3, 7}) {
+        std::vector<float> state = simulate(workerCount);
+        if (state.size() != reference.size()
+            || std::memcmp(state.data(), reference.data(), state.size() * sizeof(float)) != 0) {
+            std::cerr << "Particle state with " << workerCount << " workers differs from the serial run" << std::endl;
+            ++failures;
+        }
+    }
+
+    if (failures > 0) {
+        return 1;
+    }
+    std::cout << "Particle state is identical for every worker count" << std::endl;
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "analysis/sliding_median.h"
+
+// Median of the window by sorting a copy
+static float bruteForceMedian(const std::deque<float>& window) {
+    std::vector<float> sorted(window.begin(), window.end());
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    return (n % 2) ? sorted[n / 2] : 0.5f * (sorted[n / 2 - 1] + sorted[n / 2]);
+}
+
+// Push values through a window, refilling it after every reset the way HPSS
+// does once per hop, and compare each median against the sorted window
+static int checkWindow(int windowSize, const std::vector<float>& values, int refillEvery) {
+    SlidingMedian median;
+    if (!median.initialize(windowSize)) {
+        return 1;
+    }
+
+    std::deque<float> window;
+    int mismatches = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (refillEvery > 0 && i % refillEvery == 0) {
+            median.reset();
+            window.clear();
+        }
+
+        float got = median.push(values[i]);
+        window.push_back(values[i]);
+        if (static_cast<int>(window.size()) > windowSize) {
+            window.pop_front();
+        }
+
+        float want = bruteForceMedian(window);
+        if (got != want) {
+            if (mismatches == 0) {
+                std::cerr << "Window " << windowSize << ", value " << i << ": got " << got
+                          << ", expected " << want << std::endl;
+            }
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+int main() {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+    // Mix in small integers so the heaps see plenty of ties
+    std::vector<float> noisy(4000);
+    for (float& value : noisy) {
+        value = (random() % 4 == 0) ? static_cast<float>(random() % 5) : uniform(random);
+    }
+
+    // Sorted runs push every new value into the same heap
+    std::vector<float> ascending(1000);
+    std::vector<float> descending(1000);
+    for (size_t i = 0; i < ascending.size(); ++i) {
+        ascending[i] = static_cast<float>(i);
+        descending[i] = -static_cast<float>(i);
+    }
+
+    int failures = 0;
+    for (int windowSize = 1; windowSize <= 35; ++windowSize) {
+        failures += checkWindow(windowSize, noisy, 0);
+        failures += checkWindow(windowSize, noisy, 3 * windowSize + 1);
+        failures += checkWindow(windowSize, ascending, 0);
+        failures += checkWindow(windowSize, descending, 0);
+    }
+    failures += checkWindow(187, noisy, 0);
+
+    if (failures > 0) {
+        std::cerr << failures << " sliding median mismatches" << std::endl;
+        return 1;
+    }
+    std::cout << "Sliding median matches the sorted window" << std::endl;
+    return 0;
+}